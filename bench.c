@@ -0,0 +1,470 @@
+#define KP9_NO_MAIN
+
+#include "main.c"
+
+#include <math.h>
+#include <sys/resource.h>
+
+#define BENCH_REPEATS 5
+#define BENCH_SAMPLES 1000
+#define BENCH_SORT_ROWS_MAX 10000000
+#define BENCH_ROW_SIZES_MAX 16
+
+typedef struct {
+    double *seconds;
+    int size;
+    int capacity;
+} bench_samples;
+
+typedef struct {
+    FILE *output;
+    bool is_first_result;
+    uint64_t random_state;
+} bench_state;
+
+static bench_state bench = {.random_state = 0x9E3779B97F4A7C15ULL};
+
+int parse_row_sizes(const char *text, long *row_sizes);
+
+int compare_seconds(const void *first, const void *second);
+
+int compare_by_name(const void *first, const void *second);
+
+void add_sample(bench_samples *samples, double seconds);
+
+void report_result(const char *operation, long rows, bench_samples *samples, double items_per_sample);
+
+void report_skipped(const char *operation, long rows, const char *reason);
+
+void generate_bench_file(const char *filepath, long rows);
+
+void bench_write(const char *filepath, record **data, int size);
+
+void bench_load(const char *filepath, long rows);
+
+void bench_sort(record **data, int size, int sort_rows_max);
+
+void bench_insert_delete(const char *file_name, record **data, int size);
+
+void run_benchmarks(long rows, int sort_rows_max);
+
+double get_seconds();
+
+double get_percentile(const bench_samples *samples, double percentile);
+
+uint64_t next_random();
+
+record random_record();
+
+record **copy_records_arr(record **data, int size);
+
+
+uint64_t next_random() {
+    bench.random_state ^= bench.random_state << 13;
+    bench.random_state ^= bench.random_state >> 7;
+    bench.random_state ^= bench.random_state << 17;
+
+    return bench.random_state;
+}
+
+record random_record() {
+    record data;
+
+    snprintf(data.region_name, sizeof(data.region_name), "region%llu",
+             (unsigned long long) (next_random() % 100000000));
+    data.region_area = (double) (next_random() % 1000000000) / 1000;
+    data.region_population = (int) (next_random() % (population_max + 1U));
+
+    return data;
+}
+
+double get_seconds() {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void add_sample(bench_samples *samples, double seconds) {
+    if (samples->size >= samples->capacity) {
+        samples->capacity = samples->capacity ? samples->capacity * 2 : BENCH_SAMPLES;
+        samples->seconds = (double *) realloc(samples->seconds, samples->capacity * sizeof(double));
+
+        if (samples->seconds == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            exit(1);
+        }
+    }
+
+    samples->seconds[samples->size++] = seconds;
+}
+
+int compare_seconds(const void *first, const void *second) {
+    double difference = *(const double *) first - *(const double *) second;
+
+    return (difference > 0) - (difference < 0);
+}
+
+int compare_by_name(const void *first, const void *second) {
+    return compare_records(*(const record **) first, *(const record **) second, NAME_SORT, ASCENDING_ORDER);
+}
+
+double get_percentile(const bench_samples *samples, double percentile) {
+    int index = (int) ceil(percentile * samples->size) - 1;
+
+    return samples->seconds[index < 0 ? 0 : index];
+}
+
+void report_result(const char *operation, long rows, bench_samples *samples, double items_per_sample) {
+    double total = 0;
+
+    for (int i = 0; i < samples->size; i++) {
+        total += samples->seconds[i];
+    }
+
+    qsort(samples->seconds, samples->size, sizeof(double), compare_seconds);
+
+    fprintf(bench.output, "%s\n    {\"operation\": \"%s\", \"rows\": %li, \"samples\": %i, "
+                          "\"total_seconds\": %.6f, \"throughput_per_second\": %.1f, "
+                          "\"p50_us\": %.2f, \"p90_us\": %.2f, \"p99_us\": %.2f, \"max_us\": %.2f}",
+            bench.is_first_result ? "" : ",", operation, rows, samples->size, total,
+            total > 0 ? items_per_sample * samples->size / total : 0,
+            get_percentile(samples, 0.5) * 1e6, get_percentile(samples, 0.9) * 1e6,
+            get_percentile(samples, 0.99) * 1e6, samples->seconds[samples->size - 1] * 1e6);
+
+    bench.is_first_result = false;
+    samples->size = 0;
+}
+
+void report_skipped(const char *operation, long rows, const char *reason) {
+    fprintf(bench.output, "%s\n    {\"operation\": \"%s\", \"rows\": %li, \"skipped\": \"%s\"}",
+            bench.is_first_result ? "" : ",", operation, rows, reason);
+
+    bench.is_first_result = false;
+}
+
+record **copy_records_arr(record **data, int size) {
+    record **copy = (record **) malloc((size > 0 ? size : 1) * sizeof(record *));
+
+    if (copy == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(1);
+    }
+
+    memcpy(copy, data, size * sizeof(record *));
+
+    return copy;
+}
+
+void generate_bench_file(const char *filepath, long rows) {
+    write_buffer buffer;
+    FILE *file = fopen(filepath, "w");
+
+    if (file == NULL || !init_write_buffer(&buffer, file, WRITE_BUFFER_SIZE)) {
+        fprintf(stderr, "Error: Can't create %s\n", filepath);
+        exit(1);
+    }
+
+    for (long i = 0; i < rows; i++) {
+        record data = random_record();
+        buffer_write_record(&buffer, &data);
+    }
+
+    flush_write_buffer(&buffer);
+    free_write_buffer(&buffer);
+    fclose(file);
+}
+
+void bench_load(const char *filepath, long rows) {
+    bench_samples samples = {0};
+    int size = 0;
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        FILE *file = fopen(filepath, "r");
+        double start = get_seconds();
+        record **data = get_records_arr(file, &size);
+
+        add_sample(&samples, get_seconds() - start);
+        free_records_arr(data, size);
+        fclose(file);
+    }
+
+    report_result("get_records_arr", rows, &samples, (double) rows);
+    free(samples.seconds);
+}
+
+void bench_write(const char *filepath, record **data, int size) {
+    bench_samples samples = {0};
+    write_buffer buffer;
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        FILE *file = fopen(filepath, "w");
+        double start = get_seconds();
+
+        for (int i = 0; i < size; i++) {
+            write_record(file, data[i]);
+        }
+
+        fflush(file);
+        add_sample(&samples, get_seconds() - start);
+        fclose(file);
+    }
+
+    report_result("write_record", size, &samples, (double) size);
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        FILE *file = fopen(filepath, "w");
+        double start = get_seconds();
+
+        init_write_buffer(&buffer, file, WRITE_BUFFER_SIZE);
+
+        for (int i = 0; i < size; i++) {
+            buffer_write_record(&buffer, data[i]);
+        }
+
+        flush_write_buffer(&buffer);
+        add_sample(&samples, get_seconds() - start);
+        free_write_buffer(&buffer);
+        fclose(file);
+    }
+
+    report_result("buffer_write_record", size, &samples, (double) size);
+    free(samples.seconds);
+}
+
+void bench_sort(record **data, int size, int sort_rows_max) {
+    bench_samples samples = {0};
+    char operation[64];
+
+    for (int sort = 0; sort < NUMBER_OF_SORTS; sort++) {
+        for (int order = 0; order < NUMBER_OF_ORDERS; order++) {
+            snprintf(operation, sizeof(operation), "sort_records/%s/%s", sort_option_names[sort],
+                     order == ASCENDING_ORDER ? "ascending" : "descending");
+
+            if (size > sort_rows_max) {
+                report_skipped(operation, size, "rows above --sort-max");
+                continue;
+            }
+
+            for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+                record **copy = copy_records_arr(data, size);
+                double start = get_seconds();
+
+                sort_records(copy, size, sort, order);
+                add_sample(&samples, get_seconds() - start);
+                free(copy);
+            }
+
+            report_result(operation, size, &samples, (double) size);
+        }
+    }
+
+    sort_keys keys = {NUMBER_OF_SORTS, {POPULATION_SORT, AREA_SORT, NAME_SORT},
+                      {DESCENDING_ORDER, ASCENDING_ORDER, ASCENDING_ORDER}};
+
+    if (size > sort_rows_max) {
+        report_skipped("sort_records_by_keys/population,area,name", size, "rows above --sort-max");
+    } else {
+        for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+            record **copy = copy_records_arr(data, size);
+            double start = get_seconds();
+
+            sort_records_by_keys(copy, size, &keys);
+            add_sample(&samples, get_seconds() - start);
+            free(copy);
+        }
+
+        report_result("sort_records_by_keys/population,area,name", size, &samples, (double) size);
+    }
+
+    free(samples.seconds);
+}
+
+void bench_insert_delete(const char *file_name, record **data, int size) {
+    bench_samples samples = {0};
+    int samples_count = size < BENCH_SAMPLES ? size : BENCH_SAMPLES;
+    record **sorted = copy_records_arr(data, size);
+
+    qsort(sorted, size, sizeof(record *), compare_by_name);
+
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        record new_record = random_record();
+        double start = get_seconds();
+
+        find_insert_position((const record **) sorted, size, &new_record, NAME_SORT, ASCENDING_ORDER);
+        add_sample(&samples, get_seconds() - start);
+    }
+
+    report_result("find_insert_position", size, &samples, 1);
+    free(sorted);
+
+    char filepath[PATH_SIZE];
+    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, file_name);
+
+    FILE *file = fopen(filepath, "a+");
+    int records_size = 0;
+
+    file = open_working_log(file, (char *) file_name);
+
+    record **records = get_records_arr(file, &records_size);
+    qsort(records, records_size, sizeof(record *), compare_by_name);
+    file = checkpoint_working_file(file, (char *) file_name, records, records_size);
+
+    for (int i = 0; i < samples_count; i++) {
+        record new_record = random_record();
+        bool is_saved;
+        double start = get_seconds();
+        int position = find_insert_position((const record **) records, records_size, &new_record,
+                                            NAME_SORT, ASCENDING_ORDER);
+
+        file = save_record_change(file, (char *) file_name, &records, &records_size,
+                                  WAL_INSERT, position, NULL, &new_record, &is_saved);
+        add_sample(&samples, get_seconds() - start);
+    }
+
+    report_result("insert_record", size, &samples, 1);
+
+    for (int i = 0; i < samples_count && records_size > 0; i++) {
+        int position = (int) (next_random() % records_size);
+        record old_record = *records[position];
+        bool is_saved;
+        double start = get_seconds();
+
+        file = save_record_change(file, (char *) file_name, &records, &records_size,
+                                  WAL_DELETE, position, &old_record, NULL, &is_saved);
+        add_sample(&samples, get_seconds() - start);
+    }
+
+    report_result("delete_record", size, &samples, 1);
+
+    double start = get_seconds();
+
+    close_working_file(file, (char *) file_name);
+    add_sample(&samples, get_seconds() - start);
+    report_result("close_working_file", size, &samples, (double) records_size);
+
+    free_records_arr(records, records_size);
+}
+
+void run_benchmarks(long rows, int sort_rows_max) {
+    char file_name[FILENAME_SIZE], filepath[PATH_SIZE], write_filepath[PATH_SIZE];
+    int size = 0;
+
+    snprintf(file_name, sizeof(file_name), "bench.txt");
+    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, file_name);
+    snprintf(write_filepath, sizeof(write_filepath), "%s/write.tmp", working_folder);
+
+    generate_bench_file(filepath, rows);
+    bench_load(filepath, rows);
+
+    FILE *file = fopen(filepath, "r");
+    record **data = get_records_arr(file, &size);
+    fclose(file);
+
+    bench_write(write_filepath, data, size);
+    bench_sort(data, size, sort_rows_max);
+    bench_insert_delete(file_name, data, size);
+
+    free_records_arr(data, size);
+
+    char sidecar_filepath[PATH_SIZE];
+    get_sidecar_filepath(sidecar_filepath, sizeof(sidecar_filepath), file_name, "wal");
+    remove(sidecar_filepath);
+    get_sidecar_filepath(sidecar_filepath, sizeof(sidecar_filepath), file_name, "sorted");
+    remove(sidecar_filepath);
+    get_sidecar_filepath(sidecar_filepath, sizeof(sidecar_filepath), file_name, "idx");
+    remove(sidecar_filepath);
+    remove_record_views(file_name);
+    remove_temp_files(file_name);
+    remove(filepath);
+    remove(write_filepath);
+}
+
+int parse_row_sizes(const char *text, long *row_sizes) {
+    int count = 0;
+    char *end;
+
+    while (*text != '\0' && count < BENCH_ROW_SIZES_MAX) {
+        long rows = strtol(text, &end, 10);
+
+        if (end == text || rows <= 0 || rows > INT_MAX) {
+            return 0;
+        }
+
+        if (toupper((unsigned char) *end) == 'K') {
+            rows *= 1000;
+            end++;
+        } else if (toupper((unsigned char) *end) == 'M') {
+            rows *= 1000000;
+            end++;
+        }
+
+        row_sizes[count++] = rows;
+        text = *end == ',' ? end + 1 : end;
+
+        if (*end != ',' && *end != '\0') {
+            return 0;
+        }
+    }
+
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    long row_sizes[BENCH_ROW_SIZES_MAX] = {1000, 10000, 100000, 1000000};
+    int num_of_sizes = 4, sort_rows_max = BENCH_SORT_ROWS_MAX;
+    const char *output_path = NULL;
+    struct rusage usage;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rows") == 0 && i + 1 < argc) {
+            num_of_sizes = parse_row_sizes(argv[++i], row_sizes);
+        } else if (strcmp(argv[i], "--sort-max") == 0 && i + 1 < argc) {
+            sort_rows_max = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else {
+            num_of_sizes = 0;
+            break;
+        }
+    }
+
+    if (num_of_sizes == 0) {
+        fprintf(stderr, "Usage: %s [--rows 1K,10K,100K,1M] [--sort-max ROWS] [--output FILE]\n", argv[0]);
+        return 1;
+    }
+
+    bench.output = output_path != NULL ? fopen(output_path, "w") : stdout;
+
+    if (bench.output == NULL) {
+        perror(output_path);
+        return 1;
+    }
+
+    working_folder = "./kp9_bench_files";
+    create_working_folder(working_folder);
+
+    const char *backend_name = getenv("KP9_IO_BACKEND");
+
+    fprintf(bench.output, "{\n  \"benchmark\": \"kp9\",\n  \"io_backend\": \"%s\",\n  \"results\": [",
+            backend_name != NULL ? backend_name : "auto");
+    bench.is_first_result = true;
+
+    for (int i = 0; i < num_of_sizes; i++) {
+        run_benchmarks(row_sizes[i], sort_rows_max);
+        fflush(bench.output);
+    }
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(bench.output, "\n  ],\n  \"peak_rss_kb\": %li\n}\n", usage.ru_maxrss);
+
+    rmdir(working_folder);
+
+    if (bench.output != stdout) {
+        fclose(bench.output);
+    }
+
+    return 0;
+}
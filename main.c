@@ -4,15 +4,104 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <sys/file.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <time.h>
+#include <math.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/inotify.h>
+#include <linux/io_uring.h>
 
 #define EXIT_BUTTON 27
 #define FILENAME_SIZE 11
-#define MENU_LINES 12
+#define MENU_LINES 6
+#define MENU_COLUMNS 3
 #define REGION_NAME_MAX 21
+#define PATH_SIZE 256
+
+#define READ_BUFFER_SIZE (1 << 20)
+#define IO_CHUNK_SIZE (1 << 20)
+#define IO_QUEUE_DEPTH 8
+#define IO_ALIGNMENT 4096
+#define IO_URING_MIN_SIZE (4 * IO_CHUNK_SIZE)
+#define WRITE_BUFFER_SIZE (1 << 20)
+#define RECORD_LINE_MAX 512
+#define REJECTS_TO_SHOW 10
+
+#define BINARY_MAGIC "KP9BIN01"
+#define BINARY_MAGIC_SIZE 8
+#define BINARY_RECORD_SIZE (REGION_NAME_MAX + 1 + sizeof(double) + sizeof(int32_t))
+
+#define COLUMNAR_MAGIC "KP9COL01"
+#define COLUMNAR_MAGIC_SIZE 8
+#define COLUMNAR_BLOCK_ROWS (1 << 14)
+#define COLUMNAR_ROW_MAX 40
+#define COLUMNAR_PREFIX_TAG 32
+#define COLUMNAR_AREA_DIGITS 6
+#define COLUMNAR_AREA_XOR (-1)
+
+#define WAL_MAGIC "KP9WAL01"
+#define WAL_MAGIC_SIZE 8
+#define VIEW_MAGIC "KP9VIEW1"
+#define VIEW_MAGIC_SIZE 8
+#define SORTED_PREFIX_MAGIC "KP9SORT2"
+#define SORTED_PREFIX_MAGIC_SIZE 8
+#define LINE_INDEX_MAGIC "KP9IDX02"
+#define LINE_INDEX_MAGIC_SIZE 8
+#define LINE_INDEX_STRIDE 256
+#define WAL_GROUP_COMMIT_SIZE 64
+#define WAL_CHECKPOINT_SIZE 4096
+#define APPEND_BATCH_SIZE 64
+
+#define SERVER_THREADS_MAX 16
+#define SERVER_EVENTS_MAX 64
+#define SERVER_INPUT_SIZE (1 << 16)
+#define SERVER_INPUT_MAX (1 << 24)
+#define REQUEST_FIELDS_MAX 8
+
+#define TRACE_BUFFER_EVENTS (1 << 16)
+
+#define MERGE_FILES_MAX 64
+
+#define SORT_KEY_SIZE_MAX (sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t))
+#define SORT_RUN_SIZE 16
+
+#define TOP_RECORDS_MAX 100000
+
+#define RECORDS_PAGE_MIN 5
+#define RECORDS_PAGE_DEFAULT 20
+#define EDIT_LIST_MAX 1000
+
+#define QUERY_THREADS_MAX 64
+#define QUERY_CHUNK_SIZE (8 << 20)
+#define QUERY_RESULTS_TO_SHOW 20
+
+#define GROUP_THREADS_MAX 64
+#define GROUP_PARALLEL_MIN (1 << 16)
+#define GROUPS_TO_SHOW 20
+
+#define CATALOG_EVENTS_SIZE (1 << 16)
+#define CATALOG_PAGE_MIN 5
+#define CATALOG_PAGE_DEFAULT 20
+
+#define GENERATOR_BLOCK_ROWS (1 << 16)
+#define GENERATOR_THREADS_MAX 64
+#define GENERATOR_VOCABULARY 1000000
+#define GENERATOR_DUPLICATES 100
 
 #define RESET_TEXT "\x1b[0m"
 #define BOLD_TEXT "\x1b[1m"
@@ -27,6 +116,8 @@
 #define NOT_INTERACTIVE (-1)
 
 const char *working_folder = "./files";
+const char *export_folder = "./exports";
+const char *server_socket_name = ".kp9.sock";
 
 const int population_min = 0;
 const int population_max = 1000000000;
@@ -43,6 +134,16 @@ enum action {
     EDIT_RECORD,
     ORDER_RECORDS,
     INSERT_RECORD,
+    VIEW_RECORDS,
+    BULK_RECORDS,
+    IMPORT_RECORDS,
+    EXPORT_RECORDS,
+    MERGE_FILES,
+    QUERY_FILES,
+    TOP_RECORDS,
+    GROUP_RECORDS,
+    SHOW_STATS,
+    NUMBER_OF_ACTIONS
 };
 
 enum sort_option {
@@ -58,6 +159,139 @@ enum order_option {
     NUMBER_OF_ORDERS
 };
 
+enum record_status {
+    RECORD_OK,
+    RECORD_END,
+    RECORD_BAD_FIELDS,
+    RECORD_BAD_NAME,
+    RECORD_BAD_AREA,
+    RECORD_BAD_POPULATION,
+    RECORD_AREA_OUT_OF_RANGE,
+    RECORD_POPULATION_OUT_OF_RANGE,
+    NUMBER_OF_RECORD_STATUSES
+};
+
+const char *action_names[] = {"",
+                              "Create file",
+                              "Open file",
+                              "Delete file",
+                              "Create record",
+                              "Read record",
+                              "Delete record",
+                              "Edit record",
+                              "Order records",
+                              "Insert record",
+                              "Sorted view",
+                              "Bulk change",
+                              "Import records",
+                              "Export records",
+                              "Merge files",
+                              "Query all files",
+                              "Top records",
+                              "Group by name",
+                              "Show stats"};
+
+const enum action menu_columns[MENU_COLUMNS][2] = {{CREATE_FILE,    DELETE_FILE},
+                                                   {CREATE_RECORD,  BULK_RECORDS},
+                                                   {IMPORT_RECORDS, NUMBER_OF_ACTIONS - 1}};
+const int menu_column_widths[MENU_COLUMNS] = {15, 17, 19};
+
+const char *record_status_names[] = {"ok",
+                                     "end of file",
+                                     "wrong number of fields",
+                                     "invalid region name",
+                                     "invalid area",
+                                     "invalid population",
+                                     "area out of range",
+                                     "population out of range"};
+
+enum wal_operation {
+    WAL_APPEND = 1,
+    WAL_DELETE,
+    WAL_EDIT,
+    WAL_INSERT,
+    WAL_IMPORT
+};
+
+enum export_format {
+    CSV_FORMAT,
+    JSON_LINES_FORMAT,
+    BINARY_FORMAT,
+    COLUMNAR_FORMAT,
+    NUMBER_OF_FORMATS
+};
+
+const char *export_format_names[] = {"CSV",
+                                     "JSON Lines",
+                                     "binary",
+                                     "compressed columnar"};
+const char *export_format_extensions[] = {"csv",
+                                          "jsonl",
+                                          "bin",
+                                          "kp9c"};
+
+const double decimal_scales[COLUMNAR_AREA_DIGITS + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+
+enum value_distribution {
+    UNIFORM_DISTRIBUTION,
+    ZIPF_DISTRIBUTION,
+    SORTED_DISTRIBUTION,
+    REVERSE_DISTRIBUTION,
+    DUPLICATES_DISTRIBUTION,
+    NUMBER_OF_DISTRIBUTIONS
+};
+
+const char *distribution_names[] = {"uniform",
+                                    "zipf",
+                                    "sorted",
+                                    "reverse",
+                                    "duplicates"};
+
+enum metric_timer {
+    LOAD_TIMER,
+    READ_TIMER,
+    PARSE_TIMER,
+    SORT_TIMER,
+    REWRITE_TIMER,
+    RENDER_TIMER,
+    INPUT_TIMER,
+    NUMBER_OF_TIMERS
+};
+
+enum metric_counter {
+    BYTES_READ_COUNTER,
+    BYTES_WRITTEN_COUNTER,
+    ALLOCATIONS_COUNTER,
+    RECORDS_LOADED_COUNTER,
+    FSYNCS_COUNTER,
+    NUMBER_OF_COUNTERS
+};
+
+const char *metric_timer_names[] = {"load",
+                                    "read",
+                                    "parse",
+                                    "sort",
+                                    "rewrite",
+                                    "render",
+                                    "input"};
+
+const char *metric_counter_names[] = {"bytes_read",
+                                      "bytes_written",
+                                      "allocations",
+                                      "records_loaded",
+                                      "fsyncs"};
+
+enum catalog_sort {
+    CATALOG_NAME_SORT,
+    CATALOG_SIZE_SORT,
+    CATALOG_MTIME_SORT,
+    NUMBER_OF_CATALOG_SORTS
+};
+
+const char *catalog_sort_names[] = {"name",
+                                    "size",
+                                    "modification time"};
+
 const char *sort_option_names[] = {"name",
                                    "area",
                                    "population"};
@@ -70,1372 +304,9579 @@ typedef struct {
     int region_population;
 } record;
 
-static struct termios stored_settings;
+typedef struct {
+    uint32_t checksum;
+    int32_t operation;
+    int32_t position;
+    int32_t size;
+    record old_record;
+    record new_record;
+} wal_entry;
 
-int get_terminal_lines();
+typedef struct {
+    int fd;
+    void *sq_ring;
+    void *cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned unsubmitted;
+} io_ring;
+
+typedef struct chunk_reader {
+    int fd;
+    bool is_seekable;
+    off_t length;
+    off_t offset;
+    int depth;
+    int next_slot;
+    int used_slot;
+    char *buffers[IO_QUEUE_DEPTH];
+    off_t offsets[IO_QUEUE_DEPTH];
+    size_t sizes[IO_QUEUE_DEPTH];
+    ssize_t results[IO_QUEUE_DEPTH];
+    bool is_submitted[IO_QUEUE_DEPTH];
+    bool is_done[IO_QUEUE_DEPTH];
+    io_ring ring;
+    const struct io_backend *backend;
+} chunk_reader;
+
+typedef struct io_backend {
+    const char *name;
+    bool (*open)(chunk_reader *reader);
+    ssize_t (*next)(chunk_reader *reader, char **chunk);
+    void (*close)(chunk_reader *reader);
+} io_backend;
 
-int get_user_choice(enum action current_option, bool *is_exit, bool *is_chosen);
+typedef struct {
+    int fd;
+    chunk_reader io;
+    char *chunk;
+    size_t chunk_position;
+    size_t chunk_length;
+    char *buffer;
+    size_t capacity;
+    size_t position;
+    size_t length;
+    long line_number;
+    off_t line_offset;
+    off_t line_limit;
+    char delimiter;
+    bool is_eof;
+    bool is_format_checked;
+    bool is_columnar;
+    record *block;
+    int block_size;
+    int block_position;
+} record_reader;
 
-int navigate_list(int current_position, int size, bool *is_exit, bool *is_chosen);
+typedef struct {
+    char name_prefix[REGION_NAME_MAX];
+    double min_area;
+    double max_area;
+    int min_population;
+    int max_population;
+} record_filter;
 
-int compare_records(const record *record1, const record *record2,
-                    enum sort_option sort_option, enum order_option order_option);
+typedef struct {
+    record data;
+    bool is_name_set;
+    bool is_area_set;
+    bool is_population_set;
+} record_update;
 
-int find_insert_position(const record **data, int size, const record *new_record,
-                         enum sort_option sorting_option, enum order_option ordering_option);
+typedef struct {
+    FILE *file;
+    char *data;
+    size_t size;
+    size_t capacity;
+    uint32_t checksum;
+    uint64_t written;
+} write_buffer;
 
-void display_menu(enum action current_option, char *opened_file_name, FILE *opened_file);
+typedef struct {
+    uint64_t significand;
+    int exponent;
+} binary_float;
 
-void create_working_folder(const char *folder_name);
+typedef struct {
+    uint32_t rows;
+    uint32_t dictionary_size;
+    uint32_t payload_size;
+    uint32_t checksum;
+    int32_t area_digits;
+} columnar_header;
 
-void set_keypress();
+typedef struct {
+    char *names;
+    size_t names_size;
+    size_t names_capacity;
+    uint32_t *offsets;
+    uint32_t *ranks;
+    int size;
+    int capacity;
+    int *slots;
+    int slots_capacity;
+} name_pool;
 
-void reset_keypress();
+typedef struct {
+    const char *name;
+    int id;
+} pool_entry;
 
-void show_files(int current_position, char **files, int size);
+typedef struct {
+    int size;
+    enum sort_option sorts[NUMBER_OF_SORTS];
+    enum order_option orders[NUMBER_OF_SORTS];
+} sort_keys;
 
-void free_records_arr(record **data, int size);
+typedef struct {
+    const unsigned char *key;
+    int index;
+} keyed_record;
 
-void free_filenames_arr(char **files, int size);
+typedef struct {
+    record data;
+    long position;
+} top_record;
 
-void write_record(FILE *file, record *data);
+typedef struct {
+    write_buffer *buffer;
+    record *rows;
+    int size;
+    int *ids;
+    name_pool pool;
+} columnar_writer;
 
-void create_file();
+typedef struct {
+    long count;
+    double area_sum;
+    long long population_sum;
+    double min_area;
+    double max_area;
+    int min_population;
+    int max_population;
+} query_totals;
 
-void create_record(FILE *working_file, char *working_file_name);
+typedef struct {
+    int file;
+    off_t start;
+    off_t end;
+    record *results;
+    int size;
+    int capacity;
+    query_totals totals;
+    bool is_overlay;
+    bool is_done;
+    bool is_failed;
+} query_task;
 
-void show_records(int current_position, char *working_file_name, int size, record **data);
+typedef struct {
+    int *tasks;
+    int top;
+    int bottom;
+    pthread_mutex_t mutex;
+} task_deque;
 
-void read_record(FILE *working_file, char *working_file_name);
+typedef struct {
+    FILE *file;
+    wal_entry *entries;
+    int size;
+    int records;
+} log_snapshot;
 
-void show_sort_options(enum sort_option current_option);
+typedef struct {
+    char **names;
+    query_task *tasks;
+    int num_of_tasks;
+    task_deque deques[QUERY_THREADS_MAX];
+    int num_of_workers;
+    record_filter filter;
+    log_snapshot *logs;
+    pthread_mutex_t mutex;
+    pthread_cond_t task_done;
+} cross_file_query;
 
-void show_order_options(enum order_option current_option);
+typedef struct {
+    cross_file_query *query;
+    int index;
+} query_worker_argument;
 
-void swap_records(record **record1, record **record2);
+typedef struct {
+    const char *name;
+    int first;
+    int last;
+    query_totals totals;
+} record_group;
 
-void sort_records(record **data, int size,
-                  enum sort_option sort_option,
-                  enum order_option order_option);
+typedef struct {
+    record **data;
+    int size;
+    uint32_t *hashes;
+    int *order;
+    int *counts;
+    record_group **groups;
+    int *num_of_groups;
+    int num_of_workers;
+    pthread_mutex_t start_mutex;
+    pthread_barrier_t barrier;
+} group_query;
 
-bool input_double(double *input);
+typedef struct {
+    group_query *query;
+    int index;
+} group_worker_argument;
 
-bool input_int(int *input);
+typedef struct {
+    bool is_present;
+    bool is_stale;
+    off_t size;
+    struct timespec mtime;
+    off_t scanned_size;
+    struct timespec scanned_mtime;
+    long records;
+    int sort_option;
+    int order_option;
+} catalog_entry;
 
-bool is_correct_area(const double *area, double min, double max);
+typedef struct {
+    bool is_loaded;
+    bool is_order_valid;
+    int inotify_fd;
+    name_pool names;
+    catalog_entry *entries;
+    int entries_capacity;
+    int *order;
+    int order_size;
+    enum catalog_sort sort;
+    pthread_mutex_t mutex;
+} file_catalog;
 
-bool is_correct_population(const int *population, double min, double max);
+typedef struct {
+    char magic[WAL_MAGIC_SIZE];
+    uint32_t base_checksum;
+    uint32_t reserved;
+    uint64_t base_length;
+} wal_header;
 
-bool file_exists(const char *filepath);
+typedef struct {
+    char magic[VIEW_MAGIC_SIZE];
+    uint32_t base_checksum;
+    int32_t size;
+    uint64_t base_length;
+} view_header;
 
-bool string_input(char *line, int max_len);
+typedef struct {
+    char magic[SORTED_PREFIX_MAGIC_SIZE];
+    uint32_t base_checksum;
+    int32_t prefix;
+    uint64_t base_length;
+    int32_t keys_size;
+    int32_t sorts[NUMBER_OF_SORTS];
+    int32_t orders[NUMBER_OF_SORTS];
+    int32_t entries;
+} sorted_prefix_header;
 
-bool is_valid_filename(const char *filename);
+typedef struct {
+    char magic[LINE_INDEX_MAGIC_SIZE];
+    uint32_t base_checksum;
+    int32_t stride;
+    uint64_t base_length;
+    int32_t records;
+    int32_t size;
+    uint64_t data_device;
+    uint64_t data_inode;
+    int64_t data_mtime;
+} line_index_header;
 
-bool is_sorted(record **data, int size, enum sort_option sort, enum order_option order);
+typedef struct {
+    line_index_header header;
+    uint64_t *offsets;
+    int capacity;
+} line_index;
 
-bool check_sort_order(record **data, int size,
-                      enum sort_option *found_sort_option,
-                      enum order_option *found_order_option);
+typedef struct {
+    int first;
+    int length;
+    bool is_changed;
+    record data;
+} overlay_segment;
 
-char key_pressed();
+typedef struct {
+    record_reader reader;
+    overlay_segment *segments;
+    int size;
+    int segment;
+    int offset;
+    int base_position;
+} overlay_reader;
 
-char **get_filenames_arr(const char *folder, int *num_of_files);
+typedef struct {
+    int fd;
+    FILE *data_file;
+    wal_header header;
+    wal_entry *entries;
+    int size;
+    int capacity;
+    int unsynced;
+    int lock_depth;
+    int lock_mode;
+    uint64_t checkpoints;
+    char data_path[PATH_SIZE];
+} write_ahead_log;
 
-record **get_records_arr(FILE *working_file, int *size);
+typedef struct {
+    char name[FILENAME_SIZE];
+    FILE *file;
+    write_ahead_log log;
+    record **data;
+    int size;
+    pthread_mutex_t mutex;
+} cached_file;
+
+typedef struct server_connection {
+    int fd;
+    FILE *output;
+    char *input;
+    size_t input_size;
+    size_t input_capacity;
+    bool is_busy;
+    bool is_closed;
+    pthread_mutex_t mutex;
+    struct server_connection *next;
+} server_connection;
 
-FILE *open_file(FILE *opened_file, char **file_name);
+typedef struct {
+    int epoll_fd;
+    volatile sig_atomic_t is_stopped;
+    cached_file **files;
+    int files_size;
+    int files_capacity;
+    pthread_mutex_t cache_mutex;
+    server_connection *queue_head;
+    server_connection *queue_tail;
+    pthread_mutex_t queue_mutex;
+    pthread_cond_t queue_ready;
+} server_state;
 
-FILE *delete_file(FILE *working_file);
+typedef struct {
+    FILE *file;
+    long rows;
+    enum export_format format;
+    enum value_distribution distribution;
+    int min_name_length;
+    int max_name_length;
+    int ordered_width;
+    uint64_t seed;
+    long next_block;
+    long written_blocks;
+    bool is_failed;
+    pthread_mutex_t mutex;
+    pthread_cond_t turn;
+} record_generator;
 
-FILE *delete_record(FILE *working_file, char *working_file_name);
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} metric_timer_value;
 
-FILE *edit_record(FILE *working_file, char *working_file_name);
+typedef struct {
+    bool is_enabled;
+    metric_timer_value timers[NUMBER_OF_TIMERS];
+    uint64_t counters[NUMBER_OF_COUNTERS];
+} metrics_state;
 
-FILE *order_records(FILE *working_file, char *working_file_name);
+typedef struct {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+} trace_event;
+
+typedef struct trace_buffer {
+    long tid;
+    uint64_t size;
+    trace_event events[TRACE_BUFFER_EVENTS];
+    struct trace_buffer *next;
+} trace_buffer;
 
-FILE *insert_record(FILE *working_file, char *working_file_name);
+typedef struct {
+    bool is_enabled;
+    char path[PATH_SIZE];
+    uint64_t start_ns;
+    trace_buffer *buffers;
+    pthread_mutex_t mutex;
+} trace_state;
 
+static struct termios stored_settings;
 
-int get_terminal_lines() {
-    struct winsize ws;
-    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == -1) {
-        perror("ioctl");
-        return -1; // Error
-    }
-    return ws.ws_row;
-}
+static uint32_t checksum_table[256];
 
-int get_user_choice(enum action current_option, bool *is_exit, bool *is_chosen) {
-    char key;
+static pthread_once_t checksum_table_once = PTHREAD_ONCE_INIT;
 
-    key = (char) toupper(key_pressed());
+static metrics_state metrics = {.is_enabled = true};
 
-    switch (key) {
-        case 'W':
-            if (current_option > CREATE_FILE) {
-                current_option = (enum action) (current_option - 1);
-            }
-            break;
-        case 'A':
-            if (current_option >= CREATE_RECORD && current_option <= DELETE_RECORD) {
-                current_option = (enum action) (current_option - 3);
-            } else if (current_option >= EDIT_RECORD && current_option <= INSERT_RECORD) {
-                current_option = DELETE_RECORD;
-            }
-            break;
-        case 'S':
-            if (current_option < INSERT_RECORD) {
-                current_option = (enum action) (current_option + 1);
-            }
-            break;
-        case 'D':
-            if (current_option >= CREATE_FILE && current_option <= DELETE_FILE) {
-                current_option = (enum action) (current_option + 3);
-            }
-            break;
-        case '\n':
-            *is_chosen = true;
-            break;
-        case EXIT_BUTTON:
-            *is_exit = true;
-        default:
-            break;
-    }
+static trace_state tracing = {.mutex = PTHREAD_MUTEX_INITIALIZER};
 
-    return current_option;
-}
+static file_catalog catalog = {.inotify_fd = -1, .mutex = PTHREAD_MUTEX_INITIALIZER};
 
-int navigate_list(int current_position, int size, bool *is_exit, bool *is_chosen) {
-    char key;
+static __thread trace_buffer *thread_trace = NULL;
 
-    key = (char) toupper(key_pressed());
+static write_ahead_log interactive_log = {.fd = -1};
 
-    switch (key) {
-        case 'W':
-            if (current_position > 0) {
-                current_position = current_position - 1;
-            }
-            break;
-        case 'S':
-            if (current_position < size - 1) {
-                current_position = current_position + 1;
-            }
-            break;
-        case '\n':
-            *is_chosen = true;
-            break;
-        case EXIT_BUTTON:
-            *is_exit = true;
-            break;
-        default:
-            break;
-    }
+static __thread write_ahead_log *working_log = &interactive_log;
 
-    return current_position;
-}
+static server_state record_server = {.epoll_fd = -1,
+                                     .cache_mutex = PTHREAD_MUTEX_INITIALIZER,
+                                     .queue_mutex = PTHREAD_MUTEX_INITIALIZER,
+                                     .queue_ready = PTHREAD_COND_INITIALIZER};
 
-int compare_records(const record *record1, const record *record2,
-                    enum sort_option sort_option, enum order_option order_option) {
-    int result;
+int get_terminal_lines();
 
-    switch (sort_option) {
-        case NAME_SORT:
-            result = strcmp(record1->region_name, record2->region_name);
-            break;
-        case AREA_SORT:
-            result = (record1->region_area > record2->region_area) -
-                     (record1->region_area < record2->region_area);
-            break;
-        case POPULATION_SORT:
-            result = (record1->region_population > record2->region_population) -
-                     (record1->region_population < record2->region_population);
-            break;
-        default:
-            printf("Error:" ITALIC_TEXT " Invalid sort option"
-                   RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-            result = 0;
-    }
+int run_server();
 
-    return (order_option == ASCENDING_ORDER) ? result : -result;
-}
+int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags);
 
-int find_insert_position(const record **data, int size, const record *new_record,
-                         enum sort_option sorting_option, enum order_option ordering_option) {
-    int insert_position = 0;
+int run_client();
 
-    for (int i = 0; i < size; i++) {
-        int comparison_result = compare_records(data[i], new_record, sorting_option, ordering_option);
+int run_generator(int argc, char *argv[]);
 
-        if ((ordering_option == ASCENDING_ORDER && comparison_result > 0) ||
-            (ordering_option == DESCENDING_ORDER && comparison_result < 0)) {
-            break;
-        }
+int get_user_choice(enum action current_option, bool *is_exit, bool *is_chosen);
 
-        insert_position++;
-    }
+int get_menu_column(enum action option);
 
-    return insert_position;
-}
+int navigate_list(int current_position, int size, bool *is_exit, bool *is_chosen);
 
-void display_menu(enum action current_option, char *opened_file_name, FILE *opened_file) {
+int split_fields(char *line, char delimiter, char **fields, int max_fields);
 
-    printf(GREEN_TEXT BOLD_TEXT);
-    printf("┌───────────────┬─────────────────┐\n");
-    printf("│     FILES     │     RECORDS     │\n");
-    printf("├───────────────┼─────────────────┤\n");
-    printf("│%s Create file%s│%s Create record%s│\n",
-           (current_option == CREATE_FILE) ? GREEN_BG BLACK_TEXT "-->" : "",
-           (current_option == CREATE_FILE) ? BLACK_BG GREEN_TEXT "" : "   ",
-           (current_option == CREATE_RECORD) ? GREEN_BG BLACK_TEXT "-->" : "",
-           (current_option == CREATE_RECORD) ? BLACK_BG GREEN_TEXT "" : "   ");
-    printf("│%s Open file%s│%s Read record%s│\n",
-           (current_option == OPEN_FILE) ? GREEN_BG BLACK_TEXT "-->" : "",
-           (current_option == OPEN_FILE) ? "  " BLACK_BG GREEN_TEXT : "     ",
-           (current_option == READ_RECORD) ? GREEN_BG BLACK_TEXT "-->" : "",
-           (current_option == READ_RECORD) ? "  " BLACK_BG GREEN_TEXT : "     ");
-    printf("│%s Delete file%s│%s Delete record%s│\n",
-           (current_option == DELETE_FILE) ? GREEN_BG BLACK_TEXT "-->" : "",
-           (current_option == DELETE_FILE) ? "" BLACK_BG GREEN_TEXT : "   ",
-           (current_option == DELETE_RECORD) ? GREEN_BG BLACK_TEXT "-->" : "",
-           (current_option == DELETE_RECORD) ? BLACK_BG GREEN_TEXT "" : "   ");
-    printf("│               │%s Edit record%s│\n",
-           (current_option == EDIT_RECORD) ? GREEN_BG BLACK_TEXT "-->" : "",
-           (current_option == EDIT_RECORD) ? "  " BLACK_BG GREEN_TEXT : "     ");
-    printf("│               │%s Order records%s│\n",
-           (current_option == ORDER_RECORDS) ? GREEN_BG BLACK_TEXT "-->" : "",
-           (current_option == ORDER_RECORDS) ? "" BLACK_BG GREEN_TEXT : "   ");
-    printf("│               │%s Insert record%s│\n",
-           (current_option == INSERT_RECORD) ? GREEN_BG BLACK_TEXT "-->" : "",
-           (current_option == INSERT_RECORD) ? "" BLACK_BG GREEN_TEXT : "   ");
-    printf("└───────────────┴─────────────────┘\n");
-    printf("\n%s %s", (opened_file == NULL) ? "" : "Current working file:",
-           (opened_file == NULL) ? "" : opened_file_name);
+int get_area_digits(const record *rows, int size);
 
-    for (int i = 0; i < get_terminal_lines() - MENU_LINES; ++i) {
-        printf("\n");
-    }
+int intern_name(name_pool *pool, const char *name);
 
-    printf("Use "GREEN_BG BLACK_TEXT"WASD"BLACK_BG GREEN_TEXT" to navigate. Press "
-           GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to exit");
+int compare_pool_entries(const void *first, const void *second);
 
-}
+int compare_record_groups(const void *first, const void *second);
 
-void create_working_folder(const char *folder_name) {
+int compare_catalog_entries(const void *first, const void *second);
 
-    if (file_exists(folder_name)) {
-        return;
-    }
+int browse_catalog(const char *title, char *chosen_name, bool *is_exit);
 
-    if (mkdir(folder_name, S_IRWXU | S_IRWXG | S_IRWXO) != 0) {
-        printf("\nError:" ITALIC_TEXT " Cant create the working folder"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-    }
+int take_query_task(cross_file_query *query, int worker);
 
-}
+int compare_records(const record *record1, const record *record2,
+                    enum sort_option sort_option, enum order_option order_option);
 
-void set_keypress() {
-    struct termios new_settings;
+int compare_records_by_keys(const record *record1, const record *record2, const sort_keys *keys);
 
-    tcgetattr(0, &stored_settings);
+int find_insert_position(const record **data, int size, const record *new_record,
+                         enum sort_option sorting_option, enum order_option ordering_option);
 
-    new_settings = stored_settings;
+int find_insert_position_by_keys(const record **data, int size, const record *new_record,
+                                 const sort_keys *keys);
 
-    new_settings.c_lflag &= (~ICANON);
-    new_settings.c_cc[VTIME] = 0;
-    new_settings.c_cc[VMIN] = 1;
+int pack_sort_key(unsigned char *key, const record *data, uint32_t name_rank, const sort_keys *keys);
 
-    tcsetattr(0, TCSANOW, &new_settings);
-}
+int compare_top_records(const top_record *first, const top_record *second, const sort_keys *keys);
 
-void reset_keypress() {
-    tcsetattr(0, TCSANOW, &stored_settings);
-}
+int find_top_records(overlay_reader *reader, const sort_keys *keys, int k, top_record *top);
 
-void show_files(int current_position, char **files, int size) {
-    printf(GREEN_TEXT BOLD_TEXT);
+int replay_sorted_prefix(int prefix, const wal_entry *entries, int count);
 
-    printf("File list:\n");
-    for (int i = 0; i < size; i++) {
-        printf("%s %s%s\n", (current_position == i) ? GREEN_BG BLACK_TEXT"-->" : "",
-               files[i], (current_position == i) ? BLACK_BG GREEN_TEXT : "");
-    }
-}
+int extend_sorted_prefix(record **data, int size, const sort_keys *keys, int prefix);
 
-void free_records_arr(record **data, int size) {
-    for (int i = 0; i < size; i++) {
-        free(data[i]);
-    }
-    free(data);
-}
+int resort_records(const char *file_name, record **data, int size, const sort_keys *keys);
 
-void free_filenames_arr(char **files, int size) {
-    for (int i = 0; i < size; i++) {
-        free(files[i]);
-    }
-    free(files);
-}
+int find_move_position(record **data, int size, int old_position, const record *new_record, const sort_keys *keys);
 
-void create_file() {
-    int num_of_files;
-    char filename[FILENAME_SIZE];
-    char **filenames = get_filenames_arr(working_folder, &num_of_files);
-    FILE *file;
+int read_indexed_records(int fd, const line_index *index, int first, int count, record *data);
 
-    system("clear");
+int get_current_records(const line_index *index);
 
-    show_files(NOT_INTERACTIVE, filenames, num_of_files);
+int resolve_base_position(int position, int size, const record **overlay);
 
+int read_current_records(int fd, const line_index *index, int first, int count, record *data);
 
-    do {
-        printf("\nEnter the file name (max %i characters): ", FILENAME_SIZE - 1);
-    } while (!string_input(filename, FILENAME_SIZE) || !is_valid_filename(filename));
+int count_base_records(FILE *working_file, const char *file_name);
 
-    char filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(filepath, sizeof(filepath), "%s/%s.txt", working_folder, filename);
+int get_base_size(const wal_entry *entries, int count, int size);
+
+int split_overlay_segment(overlay_reader *reader, int position);
+
+int find_indexed_move_position(int fd, const line_index *index, int size, int old_position,
+                               const record *new_record, const sort_keys *keys);
+
+int generate_shortest_digits(double value, char *digits, int *decimal_exponent);
+
+void display_menu(enum action current_option, char *opened_file_name, FILE *opened_file);
+
+void print_menu_item(enum action current_option, enum action item, int width);
+
+void create_working_folder(const char *folder_name);
+
+void set_keypress();
+
+void reset_keypress();
+
+void show_files(int current_position, int page_size);
+
+void round_last_digit(char *digits, int length, uint64_t delta, uint64_t rest, uint64_t ten_kappa,
+                      uint64_t distance);
+
+void free_records_arr(record **data, int size);
+
+void free_filenames_arr(char **files, int size);
+
+void write_record(FILE *file, record *data);
+
+void free_record_reader(record_reader *reader);
+
+void free_overlay_reader(overlay_reader *reader);
+
+void free_write_buffer(write_buffer *buffer);
+
+void free_columnar_writer(columnar_writer *writer);
+
+void clear_name_pool(name_pool *pool);
+
+void free_name_pool(name_pool *pool);
+
+void scan_catalog_folder();
+
+void read_catalog_events();
+
+void update_catalog_entry(const char *name, bool is_present);
+
+void scan_catalog_entry(int id);
+
+void sift_down_merge_heap(int *heap, int size, int position, const record *current,
+                          enum sort_option sort_option, enum order_option order_option);
+
+void run_query_task(cross_file_query *query, query_task *task);
+
+void add_query_totals(query_totals *totals, const query_totals *other);
+
+void show_query_totals(const char *title, const query_totals *totals);
+
+void *query_worker(void *argument);
+
+void *group_worker(void *argument);
+
+void get_sidecar_filepath(char *filepath, size_t size, const char *file_name, const char *extension);
+
+void get_view_extension(char *extension, size_t size, const sort_keys *keys);
+
+void update_record_views(const char *file_name, const wal_header *base, const wal_entry *entries, int count,
+                         record **data, int size);
+
+void remove_record_views(const char *file_name);
+
+void init_line_index(line_index *index);
+
+void stamp_line_index(const char *file_name, const wal_header *base, const struct stat *data_stat);
+
+void free_line_index(line_index *index);
+
+void extend_line_index(const char *file_name, const wal_header *base, int fd);
+
+void update_sorted_prefix(const char *file_name, const wal_header *base, const wal_entry *entries, int count,
+                          record **data, int size);
+
+void move_record(record **data, int old_position, int new_position, const record *new_record);
+
+void sync_working_folder();
+
+void close_working_file(FILE *working_file, char *working_file_name);
+
+void release_working_file(FILE *working_file);
+
+void free_log_snapshot(log_snapshot *snapshot);
+
+void lock_working_log(int operation);
+
+void unlock_working_log();
+
+void remove_temp_files(const char *file_name);
+
+void release_cached_files();
+
+void free_chunk_reader(chunk_reader *reader);
+
+void init_checksum_table();
+
+void pread_close(chunk_reader *reader);
+
+void io_uring_submit_read(chunk_reader *reader, int slot);
+
+void io_uring_reap(chunk_reader *reader);
+
+void io_uring_close(chunk_reader *reader);
+
+void serve_list(FILE *output);
+
+void serve_query(FILE *output, cached_file *file, char **arguments, int count);
+
+void serve_insert(FILE *output, cached_file *file, char **arguments, int count);
+
+void serve_delete(FILE *output, cached_file *file, char **arguments, int count);
+
+void serve_sort(FILE *output, cached_file *file, char **arguments, int count);
+
+void handle_request(FILE *output, char *line);
+
+void free_connection(server_connection *connection);
+
+void enqueue_connection(server_connection *connection);
+
+void process_connection(server_connection *connection);
+
+void *server_worker(void *argument);
+
+void *generator_worker(void *argument);
+
+void make_region_name(char *name, uint64_t key, int length, long ordered_index, int ordered_width);
+
+void generate_record(record_generator *generator, long row, uint64_t *state, record *data);
+
+void stop_server(int signal_number);
+
+void init_metrics();
+
+void stop_timer(enum metric_timer timer, uint64_t start);
+
+void add_counter(enum metric_counter counter, uint64_t value);
+
+void show_stats();
+
+void dump_metrics();
+
+void init_tracing(const char *path);
+
+void end_span(const char *name, uint64_t start);
+
+void write_trace();
+
+void accept_connection(int listen_fd);
+
+void read_connection(server_connection *connection);
+
+void create_file();
+
+void create_record(FILE *working_file, char *working_file_name);
+
+void show_records(int current_position, char *working_file_name, int size, record **data);
+
+void show_record_row(int current_position, int index, const record *data);
+
+void show_records_page(char *working_file_name, int first, int size, int records, const record *page);
+
+
+void show_sort_options(enum sort_option current_option);
+
+void show_order_options(enum order_option current_option);
+
+void swap_records(record **record1, record **record2);
+
+void sort_records(record **data, int size,
+                  enum sort_option sort_option,
+                  enum order_option order_option);
+
+void sort_records_by_keys(record **data, int size, const sort_keys *keys);
+
+void merge_sort_keyed(keyed_record *items, keyed_record *temp, int size, int key_size);
+
+void format_sort_keys(char *text, size_t size, const sort_keys *keys);
+
+void sift_down_top_heap(top_record *heap, int size, int position, const sort_keys *keys);
+
+void show_export_formats(enum export_format current_option);
+
+void input_record_filter(record_filter *filter);
+
+void input_record_update(record_update *update);
+
+void apply_record_update(record *data, const record_update *update);
+
+bool input_double(double *input);
+
+bool input_int(int *input);
+
+bool is_correct_area(const double *area, double min, double max);
+
+bool is_correct_population(const int *population, double min, double max);
+
+bool file_exists(const char *filepath);
+
+bool string_input(char *line, int max_len);
+
+bool is_valid_filename(const char *filename);
+
+bool is_sorted_by_keys(record **data, int size, const sort_keys *keys);
+
+bool sort_record_permutation(record **data, int size, const sort_keys *keys, uint32_t *permutation);
+
+bool save_record_view(const char *file_name, const sort_keys *keys, const wal_header *base,
+                      const uint32_t *permutation, int size);
+
+bool patch_record_view(const uint32_t *view, int view_size, const wal_entry *entries, int count,
+                       record **data, int size, const sort_keys *keys, uint32_t *patched);
+
+bool is_same_sort_keys(const sort_keys *keys1, const sort_keys *keys2);
+
+bool load_sorted_prefix(const char *file_name, const wal_header *base, const wal_entry *entries, int count,
+                        sort_keys *keys, int *prefix);
+
+bool add_line_offset(line_index *index, uint64_t offset);
+
+bool scan_line_index(line_index *index, int fd, off_t offset);
+
+bool load_line_index(const char *file_name, const wal_header *base, line_index *index);
+
+bool save_line_index(const char *file_name, const wal_header *base, const line_index *index);
+
+bool is_line_index_stamped(const char *file_name, const wal_header *base, const struct stat *data_stat);
+
+bool get_line_index(FILE *working_file, const char *file_name, line_index *index);
+
+bool save_sorted_prefix(const char *file_name, const wal_header *base, const sort_keys *keys, int prefix);
+
+bool breaks_sort_ties(record **data, int size, const sort_keys *keys);
+
+bool check_sort_order(record **data, int size, sort_keys *found_keys);
+
+bool add_sort_key(sort_keys *keys, enum sort_option sort_option, enum order_option order_option);
+
+bool parse_double(const char *text, double *value);
+
+bool parse_int(const char *text, int *value);
+
+bool init_record_reader(record_reader *reader, int fd);
+
+bool init_overlay_reader(overlay_reader *reader, int fd, int records, const wal_entry *entries, int count);
+
+bool init_current_reader(overlay_reader *reader, FILE *working_file, const char *file_name);
+
+bool read_overlay_record(overlay_reader *reader, record *data);
+
+bool init_record_reader_at(record_reader *reader, int fd, off_t offset, off_t limit);
+
+bool init_record_reader_range(record_reader *reader, int fd, off_t offset, off_t limit, off_t length);
+
+bool init_chunk_reader(chunk_reader *reader, int fd, off_t offset, off_t length);
+
+bool pread_open(chunk_reader *reader);
+
+bool io_uring_open(chunk_reader *reader);
+
+bool init_write_buffer(write_buffer *buffer, FILE *file, size_t capacity);
+
+bool flush_write_buffer(write_buffer *buffer);
+
+bool buffer_reserve(write_buffer *buffer, size_t size);
+
+bool buffer_write_record(write_buffer *buffer, const record *data);
+
+bool buffer_write_export(write_buffer *buffer, const record *data, enum export_format format);
+
+bool fill_record_reader(record_reader *reader);
+
+bool ensure_bytes(record_reader *reader, size_t size);
+
+bool read_columnar_block(record_reader *reader);
+
+bool decode_columnar_block(const char *payload, const columnar_header *header, record *output);
+
+bool init_columnar_writer(columnar_writer *writer, write_buffer *buffer);
+
+bool add_columnar_record(columnar_writer *writer, const record *data);
+
+bool flush_columnar_block(columnar_writer *writer);
+
+bool finish_columnar_writer(columnar_writer *writer);
+
+bool init_name_pool(name_pool *pool, int expected_size);
+
+bool grow_name_pool(name_pool *pool);
+
+bool rank_name_pool(name_pool *pool);
+
+bool refresh_catalog();
+
+bool read_valid_record(record_reader *reader, record *data);
+
+bool load_log_snapshot(log_snapshot *snapshot, const char *name, FILE *working_file, const char *working_file_name);
+
+bool open_merge_input(overlay_reader *reader, FILE **file, const char *name,
+                      FILE *working_file, const char *working_file_name);
+
+bool is_merge_before(const record *current, int first, int second,
+                     enum sort_option sort_option, enum order_option order_option);
+
+bool get_file_checksum(int fd, uint64_t length, uint32_t *checksum);
+
+bool reset_working_log(uint32_t base_checksum, uint64_t base_length);
+
+bool reserve_wal_entries(int count);
+
+bool add_wal_entry(const wal_entry *entry);
+
+bool log_record_change(const wal_entry *entry);
+
+bool log_record_changes(const wal_entry *entries, int count);
+
+bool append_records(FILE *working_file, const wal_entry *entries, int count);
+
+bool commit_working_log();
+
+bool apply_wal_entry(record ***data, int *size, int *capacity, const wal_entry *entry);
+
+bool is_valid_wal_entry(const wal_entry *entry);
+
+bool is_same_record(const record *record1, const record *record2);
+
+bool refresh_working_log(FILE *working_file);
+
+bool load_cached_file(cached_file *file);
+
+bool get_server_address(struct sockaddr_un *address);
+
+bool write_all(int fd, const char *data, size_t size);
+
+bool matches_filter(const record *data, const record_filter *filter);
+
+bool aggregate_group_partition(group_query *query, int partition, int start, int end);
+
+bool input_sort_options(sort_keys *keys, int max_keys);
+
+char key_pressed();
+
+char detect_delimiter(const char *line);
+
+char *read_line(record_reader *reader);
+
+char *format_unsigned(char *output, uint64_t value);
+
+char *format_int(char *output, int value);
+
+char *format_double(char *output, double value);
+
+char *write_varint(char *output, uint64_t value);
+
+const char *read_varint(const char *input, const char *end, uint64_t *value);
+
+uint32_t update_checksum(uint32_t checksum, const void *data, size_t size);
+
+uint32_t hash_name(const char *name);
+
+uint64_t next_generator_random(uint64_t *state);
+
+uint64_t get_time_ns();
+
+uint64_t start_timer();
+
+uint64_t begin_span();
+
+long get_zipf_rank(uint64_t *state, long vocabulary);
+
+long get_file_sort_orders(const char *filepath, bool is_ordered[NUMBER_OF_SORTS][NUMBER_OF_ORDERS]);
+
+long get_reader_sort_orders(overlay_reader *reader, bool is_ordered[NUMBER_OF_SORTS][NUMBER_OF_ORDERS]);
+
+char **get_filenames_arr(int *num_of_files);
+
+trace_buffer *get_trace_buffer();
+
+binary_float normalize_binary_float(binary_float value);
+
+binary_float multiply_binary_floats(binary_float first, binary_float second);
+
+binary_float get_cached_power(int exponent, int *decimal_exponent);
+
+record **get_records_arr(FILE *working_file, int *size);
+
+uint32_t *load_record_view(const char *file_name, const sort_keys *keys, const wal_header *base, int size);
+
+record **read_records_arr(FILE *working_file, int *size);
+
+enum record_status read_next_record(record_reader *reader, record *data);
+
+enum record_status validate_record(const record *data);
+
+wal_entry make_wal_entry(enum wal_operation operation, int position, int size,
+                         const record *old_record, const record *new_record);
+
+ssize_t next_chunk(chunk_reader *reader, char **chunk);
+
+ssize_t pread_next(chunk_reader *reader, char **chunk);
+
+ssize_t io_uring_next(chunk_reader *reader, char **chunk);
+
+cached_file *get_cached_file(const char *file_name);
+
+record_group *group_records(record **data, int size, int *num_of_groups);
+
+server_connection *dequeue_connection();
+
+FILE *open_working_log(FILE *working_file, char *working_file_name);
+
+FILE *checkpoint_working_file(FILE *working_file, char *working_file_name, record **data, int size);
+
+FILE *flush_working_log(FILE *working_file, char *working_file_name, int min_entries);
+
+FILE *save_record_change(FILE *working_file, char *working_file_name, record ***data, int *size,
+                         enum wal_operation operation, int position,
+                         const record *old_record, const record *new_record, bool *is_saved);
+
+FILE *save_record_move(FILE *working_file, char *working_file_name, record ***data, int *size,
+                       int old_position, int *new_position, const sort_keys *keys,
+                       const record *old_record, const record *new_record, bool *is_saved);
+
+FILE *rewrite_matching_records(FILE *working_file, char *working_file_name, const record_filter *filter,
+                               const record_update *update, int *scanned, int *changed, bool *is_saved);
+
+FILE *open_file(FILE *opened_file, char **file_name);
+
+FILE *delete_file(FILE *working_file, char *working_file_name);
+
+FILE *read_record(FILE *working_file, char *working_file_name);
+
+FILE *delete_record(FILE *working_file, char *working_file_name);
+
+FILE *edit_record(FILE *working_file, char *working_file_name);
+
+FILE *edit_indexed_record(FILE *working_file, char *working_file_name, line_index *index);
+
+FILE *order_records(FILE *working_file, char *working_file_name);
+
+FILE *insert_record(FILE *working_file, char *working_file_name);
+
+FILE *import_records(FILE *working_file, char *working_file_name);
+
+FILE *export_records(FILE *working_file, char *working_file_name);
+
+FILE *merge_files(FILE *working_file, char *working_file_name);
+
+FILE *query_files(FILE *working_file, char *working_file_name);
+
+FILE *compact_records(FILE *working_file, char *working_file_name, record **data, int size,
+                      const record_group *groups, int num_of_groups, bool *is_saved);
+
+FILE *group_by_name(FILE *working_file, char *working_file_name);
+
+FILE *top_records(FILE *working_file, char *working_file_name);
+
+FILE *view_records(FILE *working_file, char *working_file_name);
+
+FILE *bulk_change_records(FILE *working_file, char *working_file_name);
+
+const io_backend pread_backend = {"pread", pread_open, pread_next, pread_close};
+const io_backend io_uring_backend = {"io_uring", io_uring_open, io_uring_next, io_uring_close};
+
+
+int get_terminal_lines() {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == -1) {
+        perror("ioctl");
+        return -1; // Error
+    }
+    return ws.ws_row;
+}
+
+int get_user_choice(enum action current_option, bool *is_exit, bool *is_chosen) {
+    char key;
+    int column = get_menu_column(current_option);
+    int row = current_option - menu_columns[column][0];
+
+    key = (char) toupper(key_pressed());
+
+    switch (key) {
+        case 'W':
+            if (current_option > CREATE_FILE) {
+                current_option = (enum action) (current_option - 1);
+            }
+            break;
+        case 'A':
+            if (column > 0) {
+                column--;
+                current_option = (enum action) (menu_columns[column][0] + row);
+
+                if (current_option > menu_columns[column][1]) {
+                    current_option = menu_columns[column][1];
+                }
+            }
+            break;
+        case 'S':
+            if (current_option < NUMBER_OF_ACTIONS - 1) {
+                current_option = (enum action) (current_option + 1);
+            }
+            break;
+        case 'D':
+            if (column < MENU_COLUMNS - 1) {
+                column++;
+                current_option = (enum action) (menu_columns[column][0] + row);
+
+                if (current_option > menu_columns[column][1]) {
+                    current_option = menu_columns[column][1];
+                }
+            }
+            break;
+        case '\n':
+            *is_chosen = true;
+            break;
+        case EXIT_BUTTON:
+            *is_exit = true;
+        default:
+            break;
+    }
+
+    return current_option;
+}
+
+int get_menu_column(enum action option) {
+    for (int column = 0; column < MENU_COLUMNS; column++) {
+        if (option >= menu_columns[column][0] && option <= menu_columns[column][1]) {
+            return column;
+        }
+    }
+
+    return 0;
+}
+
+int navigate_list(int current_position, int size, bool *is_exit, bool *is_chosen) {
+    char key;
+
+    key = (char) toupper(key_pressed());
+
+    switch (key) {
+        case 'W':
+            if (current_position > 0) {
+                current_position = current_position - 1;
+            }
+            break;
+        case 'S':
+            if (current_position < size - 1) {
+                current_position = current_position + 1;
+            }
+            break;
+        case '\n':
+            *is_chosen = true;
+            break;
+        case EXIT_BUTTON:
+            *is_exit = true;
+            break;
+        default:
+            break;
+    }
+
+    return current_position;
+}
+
+int compare_records(const record *record1, const record *record2,
+                    enum sort_option sort_option, enum order_option order_option) {
+    int result;
+
+    switch (sort_option) {
+        case NAME_SORT:
+            result = strcmp(record1->region_name, record2->region_name);
+            break;
+        case AREA_SORT:
+            result = (record1->region_area > record2->region_area) -
+                     (record1->region_area < record2->region_area);
+            break;
+        case POPULATION_SORT:
+            result = (record1->region_population > record2->region_population) -
+                     (record1->region_population < record2->region_population);
+            break;
+        default:
+            printf("Error:" ITALIC_TEXT " Invalid sort option"
+                   RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+            result = 0;
+    }
+
+    return (order_option == ASCENDING_ORDER) ? result : -result;
+}
+
+int compare_records_by_keys(const record *record1, const record *record2, const sort_keys *keys) {
+    int result = 0;
+
+    for (int i = 0; i < keys->size && result == 0; i++) {
+        result = compare_records(record1, record2, keys->sorts[i], keys->orders[i]);
+    }
+
+    return result;
+}
+
+int find_insert_position(const record **data, int size, const record *new_record,
+                         enum sort_option sorting_option, enum order_option ordering_option) {
+    sort_keys keys = {1, {sorting_option}, {ordering_option}};
+
+    return find_insert_position_by_keys(data, size, new_record, &keys);
+}
+
+int find_insert_position_by_keys(const record **data, int size, const record *new_record,
+                                 const sort_keys *keys) {
+    int insert_position = 0;
+
+    for (int i = 0; i < size; i++) {
+        int comparison_result = compare_records_by_keys(data[i], new_record, keys);
+
+        if (comparison_result > 0) {
+            break;
+        }
+
+        insert_position++;
+    }
+
+    return insert_position;
+}
+
+void display_menu(enum action current_option, char *opened_file_name, FILE *opened_file) {
+    int rows = 0;
+    uint64_t start = start_timer();
+
+    for (int column = 0; column < MENU_COLUMNS; column++) {
+        int column_size = menu_columns[column][1] - menu_columns[column][0] + 1;
+
+        if (column_size > rows) {
+            rows = column_size;
+        }
+    }
+
+    printf(GREEN_TEXT BOLD_TEXT);
+    printf("┌───────────────┬─────────────────┬───────────────────┐\n");
+    printf("│     FILES     │     RECORDS     │       TOOLS       │\n");
+    printf("├───────────────┼─────────────────┼───────────────────┤\n");
+
+    for (int row = 0; row < rows; row++) {
+        printf("│");
+
+        for (int column = 0; column < MENU_COLUMNS; column++) {
+            enum action item = (enum action) (menu_columns[column][0] + row);
+
+            if (item <= menu_columns[column][1]) {
+                print_menu_item(current_option, item, menu_column_widths[column]);
+            } else {
+                printf("%*s", menu_column_widths[column], "");
+            }
+
+            printf("│");
+        }
+
+        printf("\n");
+    }
+
+    printf("└───────────────┴─────────────────┴───────────────────┘\n");
+    printf("\n%s %s", (opened_file == NULL) ? "" : "Current working file:",
+           (opened_file == NULL) ? "" : opened_file_name);
+
+    for (int i = 0; i < get_terminal_lines() - rows - MENU_LINES; ++i) {
+        printf("\n");
+    }
+
+    printf("Use "GREEN_BG BLACK_TEXT"WASD"BLACK_BG GREEN_TEXT" to navigate. Press "
+           GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to exit");
+
+    stop_timer(RENDER_TIMER, start);
+}
+
+void print_menu_item(enum action current_option, enum action item, int width) {
+    int padding = width - (int) strlen(action_names[item]) - 1;
+
+    if (current_option == item) {
+        printf(GREEN_BG BLACK_TEXT "-->" " %s" BLACK_BG GREEN_TEXT "%*s",
+               action_names[item], padding - 3, "");
+    } else {
+        printf(" %s%*s", action_names[item], padding, "");
+    }
+}
+
+void create_working_folder(const char *folder_name) {
+
+    if (file_exists(folder_name)) {
+        return;
+    }
+
+    if (mkdir(folder_name, S_IRWXU | S_IRWXG | S_IRWXO) != 0) {
+        printf("\nError:" ITALIC_TEXT " Cant create the working folder"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+    }
+
+}
+
+void set_keypress() {
+    struct termios new_settings;
+
+    tcgetattr(0, &stored_settings);
+
+    new_settings = stored_settings;
+
+    new_settings.c_lflag &= (~ICANON);
+    new_settings.c_cc[VTIME] = 0;
+    new_settings.c_cc[VMIN] = 1;
+
+    tcsetattr(0, TCSANOW, &new_settings);
+}
+
+void reset_keypress() {
+    tcsetattr(0, TCSANOW, &stored_settings);
+}
+
+void show_files(int current_position, int page_size) {
+    char modified[32], order[32];
+
+    printf(GREEN_TEXT BOLD_TEXT);
+
+    pthread_mutex_lock(&catalog.mutex);
+
+    int first = current_position > 0 ? current_position / page_size * page_size : 0;
+    int pages = (catalog.order_size + page_size - 1) / page_size;
+
+    printf("File list (%i files, sorted by %s, page %i of %i):\n", catalog.order_size,
+           catalog_sort_names[catalog.sort], first / page_size + 1, pages > 0 ? pages : 1);
+    printf("    %-16s%12s%12s  %-26s%s\n", "NAME", "SIZE", "RECORDS", "ORDER", "MODIFIED");
+
+    for (int i = first; i < first + page_size && i < catalog.order_size; i++) {
+        int id = catalog.order[i];
+        catalog_entry *entry = &catalog.entries[id];
+
+        scan_catalog_entry(id);
+        strftime(modified, sizeof(modified), "%Y-%m-%d %H:%M", localtime(&entry->mtime.tv_sec));
+
+        if (entry->records < 0) {
+            strcpy(order, "?");
+        } else if (entry->records < 2) {
+            strcpy(order, "-");
+        } else if (entry->sort_option < 0) {
+            strcpy(order, "unsorted");
+        } else {
+            snprintf(order, sizeof(order), "%s, %s", sort_option_names[entry->sort_option],
+                     order_option_names[entry->order_option]);
+        }
+
+        printf("%s %-16s%12lld%12ld  %-26s%s%s\n", (current_position == i) ? GREEN_BG BLACK_TEXT"-->" : "   ",
+               catalog.names.names + catalog.names.offsets[id], (long long) entry->size, entry->records,
+               order, modified, (current_position == i) ? BLACK_BG GREEN_TEXT : "");
+    }
+
+    pthread_mutex_unlock(&catalog.mutex);
+}
+
+void free_records_arr(record **data, int size) {
+    for (int i = 0; i < size; i++) {
+        free(data[i]);
+    }
+    free(data);
+}
+
+void free_filenames_arr(char **files, int size) {
+    for (int i = 0; i < size; i++) {
+        free(files[i]);
+    }
+    free(files);
+}
+
+void create_file() {
+    char filename[FILENAME_SIZE];
+    FILE *file;
+
+    system("clear");
+
+    refresh_catalog();
+    show_files(NOT_INTERACTIVE, CATALOG_PAGE_DEFAULT);
+
+
+    do {
+        printf("\nEnter the file name (max %i characters): ", FILENAME_SIZE - 1);
+    } while (!string_input(filename, FILENAME_SIZE) || !is_valid_filename(filename));
+
+    char filepath[FILENAME_SIZE + strlen(working_folder) + 2];
+    snprintf(filepath, sizeof(filepath), "%s/%s.txt", working_folder, filename);
+
+    if (file_exists(filepath)) {
+        printf("\nFile wasn't created: "ITALIC_TEXT"%s.txt already exists"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, filename);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return;
+    }
+
+    int fd = open(filepath, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    file = fd != -1 ? fdopen(fd, "w") : NULL;
+
+    if (file == NULL) {
+        printf("\nError:" ITALIC_TEXT " Cant open the file"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return;
+    }
+
+    system("clear");
+    refresh_catalog();
+    show_files(NOT_INTERACTIVE, CATALOG_PAGE_DEFAULT);
+
+    printf("\nFile with name "GREEN_BG BLACK_TEXT"%s.txt"BLACK_BG GREEN_TEXT
+           " was created successfully!", filename);
+
+    if (fclose(file)) {
+        printf("\nError:" ITALIC_TEXT " Can't close the file"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+}
+
+bool input_double(double *input) {
+    char end_of_input = ' ';
+    double value;
+    uint64_t start = start_timer();
+
+    fflush(stdin);
+
+    bool is_read = scanf("%lf%c", &value, &end_of_input) && end_of_input == '\n';
+
+    stop_timer(INPUT_TIMER, start);
+
+    if (is_read) {
+        *input = value;
+        return true;
+    } else {
+        printf("Error:" ITALIC_TEXT "Invalid input. Please try again.\n"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        return false;
+    }
+}
+
+bool input_int(int *input) {
+    char end_of_input = ' ';
+    int value;
+    uint64_t start = start_timer();
+
+    fflush(stdin);
+
+    bool is_read = scanf("%i%c", &value, &end_of_input) && end_of_input == '\n';
+
+    stop_timer(INPUT_TIMER, start);
+
+    if (is_read) {
+        *input = value;
+        return true;
+    } else {
+        printf("Error:" ITALIC_TEXT "Invalid input. Please try again.\n"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        return false;
+    }
+}
+
+bool is_correct_area(const double *area, double min, double max) {
+    if (*area > max) {
+        printf("Error:" ITALIC_TEXT " Too large area. Area can't be larger than %lf"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, max);
+        return false;
+    }
+    if (*area < min) {
+        printf("Error:" ITALIC_TEXT " Too small area. Area can't be smaller than %lf"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, min);
+        return false;
+    }
+
+    return true;
+}
+
+void write_record(FILE *file, record *data) {
+
+    if (file == NULL) {
+        printf("\nError:" ITALIC_TEXT " file was not found"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        return;
+    }
+
+    char line[RECORD_LINE_MAX];
+    char *output = stpcpy(line, data->region_name);
+
+    *output++ = ' ';
+    output = format_double(output, data->region_area);
+    *output++ = ' ';
+    output = format_int(output, data->region_population);
+    *output++ = '\n';
+
+    fwrite(line, 1, output - line, file);
+
+    fflush(file);
+}
+
+bool is_correct_population(const int *population, double min, double max) {
+    if (*population > max) {
+        printf("Error:" ITALIC_TEXT " Too large population. Population can't be larger than %lf"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, max);
+        return false;
+    }
+    if (*population < min) {
+        printf("Error:" ITALIC_TEXT " Too small population. Population can't be smaller than %lf"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, min);
+        return false;
+    }
+
+    return true;
+}
+
+bool file_exists(const char *filepath) {
+    return !access(filepath, F_OK);
+}
+
+char key_pressed() {
+    char answer;
+    uint64_t start = start_timer();
+
+    set_keypress();
+    answer = (char) getchar();
+    reset_keypress();
+
+    stop_timer(INPUT_TIMER, start);
+
+    return answer;
+}
+
+bool string_input(char *line, int max_len) {
+    int i = 0;
+    char symbol_to_input;
+    uint64_t start = start_timer();
+
+    do {
+        symbol_to_input = (char) getchar();
+
+        if (symbol_to_input == '\n') {
+            break;
+        }
+
+        line[i] = symbol_to_input;
+        i++;
+
+    } while (i < max_len);
+
+    stop_timer(INPUT_TIMER, start);
+
+    if (symbol_to_input != '\n') {
+        printf("\nError:" ITALIC_TEXT " Input exceeds the maximum length "
+               "of %i characters. Please try again\n"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, max_len - 1);
+        fflush(stdin);
+        return false;
+    }
+
+    line[i] = '\0';
+
+    return true;
+}
+
+bool is_valid_filename(const char *filename) {
+    if (filename == NULL || strlen(filename) == 0) {
+        printf("\nEmpty input. Please try again\n");
+        return false;
+    }
+
+    const char *invalid_chars = "\\/:*?\"<>|";
+    size_t filename_len = strlen(filename);
+
+    if (filename[0] == '.') {
+        printf("\nInvalid filename! Filename cannot start with '.'");
+        return false;
+    }
+
+    for (size_t i = 0; i < filename_len; i++) {
+        for (int j = 0; j < strlen(invalid_chars); j++) {
+            if (filename[i] == invalid_chars[j]) {
+                printf("\nInvalid filename! Found '%c' at position %zu."
+                       "\nDon't use symbols '%s'. Please try again",
+                       invalid_chars[j], i + 1, invalid_chars);
+                return false;
+            }
+        }
+    }
+
+    if (filename[filename_len - 1] == ' ') {
+        printf("\nInvalid filename! Filename cannot end with a space. Please try again");
+        return false;
+    }
+
+    return true;
+}
+
+record **get_records_arr(FILE *working_file, int *size) {
+    if (working_file == NULL) {
+        printf("Error:" ITALIC_TEXT " No file was opened" RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        return NULL;
+    }
+
+    uint64_t start = start_timer(), span = begin_span();
+    record **data;
+
+    if (working_file != working_log->data_file) {
+        data = read_records_arr(working_file, size);
+    } else {
+        lock_working_log(LOCK_SH);
+        refresh_working_log(working_file);
+
+        data = read_records_arr(working_file, size);
+
+        unlock_working_log();
+    }
+
+    stop_timer(LOAD_TIMER, start);
+    end_span("get_records_arr", span);
+
+    return data;
+}
+
+record **read_records_arr(FILE *working_file, int *size) {
+    int capacity = 2, index = 0;
+    enum record_status status;
+    record_reader reader;
+    record input_data;
+    uint64_t start = start_timer();
+
+    fflush(working_file);
+
+    record **data = (record **) malloc(capacity * sizeof(record *));
+
+    if (data == NULL || !init_record_reader(&reader, fileno(working_file))) {
+        printf("Error:" ITALIC_TEXT " Memory allocation failed" RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        free(data);
+        return NULL;
+    }
+
+    reader.delimiter = ' ';
+
+    while ((status = read_next_record(&reader, &input_data)) != RECORD_END) {
+        if (status != RECORD_OK && status != RECORD_BAD_NAME) {
+            continue;
+        }
+
+        if (index >= capacity) {
+            capacity *= 2;
+            data = (record **) realloc(data, capacity * sizeof(record *));
+
+            if (data == NULL) {
+                printf("Error:" ITALIC_TEXT " Memory reallocation failed" RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+                free_record_reader(&reader);
+                return NULL;
+            }
+        }
+
+        data[index] = (record *) malloc(sizeof(record));
+
+        if (data[index] == NULL) {
+            printf("Error:" ITALIC_TEXT " Memory allocation failed" RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+            free_record_reader(&reader);
+            return NULL;
+        }
+
+        *data[index] = input_data;
+        index++;
+    }
+
+    free_record_reader(&reader);
+
+    add_counter(ALLOCATIONS_COUNTER, index + 1);
+    add_counter(RECORDS_LOADED_COUNTER, index);
+
+    if (working_file == working_log->data_file) {
+        for (int i = 0; i < working_log->size; i++) {
+            apply_wal_entry(&data, &index, &capacity, &working_log->entries[i]);
+        }
+    }
+
+    *size = index;
+
+    stop_timer(PARSE_TIMER, start);
+
+    return data;
+}
+
+char **get_filenames_arr(int *num_of_files) {
+    if (!refresh_catalog()) {
+        printf("Error:" ITALIC_TEXT " Cant open the directory"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&catalog.mutex);
+
+    char **files = (char **) malloc((catalog.order_size + 1) * sizeof(char *));
+    int index = 0;
+
+    for (int i = 0; files != NULL && i < catalog.order_size; i++) {
+        if ((files[index] = strdup(catalog.names.names + catalog.names.offsets[catalog.order[i]])) != NULL) {
+            index++;
+        }
+    }
+
+    pthread_mutex_unlock(&catalog.mutex);
+
+    if (files == NULL) {
+        printf("Error:" ITALIC_TEXT " Memory allocation failed"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        return NULL;
+    }
+
+    *num_of_files = index;
+
+    return files;
+}
+
+bool refresh_catalog() {
+    pthread_mutex_lock(&catalog.mutex);
+
+    if (!catalog.is_loaded) {
+        catalog.is_loaded = init_name_pool(&catalog.names, 64);
+
+        if (catalog.is_loaded) {
+            catalog.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+            if (catalog.inotify_fd != -1 &&
+                inotify_add_watch(catalog.inotify_fd, working_folder,
+                                  IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE |
+                                  IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF) == -1) {
+                close(catalog.inotify_fd);
+                catalog.inotify_fd = -1;
+            }
+
+            scan_catalog_folder();
+        }
+    } else if (catalog.inotify_fd == -1) {
+        scan_catalog_folder();
+    } else {
+        read_catalog_events();
+    }
+
+    bool is_loaded = catalog.is_loaded;
+
+    for (int id = 0; id < catalog.names.size && is_loaded; id++) {
+        catalog_entry *entry = &catalog.entries[id];
+        struct stat file_stat;
+
+        if (!entry->is_present || !entry->is_stale) {
+            continue;
+        }
+
+        char filepath[PATH_SIZE + NAME_MAX];
+        snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, catalog.names.names + catalog.names.offsets[id]);
+
+        entry->is_stale = false;
+        entry->is_present = stat(filepath, &file_stat) == 0 && S_ISREG(file_stat.st_mode);
+        catalog.is_order_valid = false;
+
+        if (entry->is_present) {
+            entry->size = file_stat.st_size;
+            entry->mtime = file_stat.st_mtim;
+        }
+    }
+
+    if (is_loaded && !catalog.is_order_valid) {
+        int *order = (int *) realloc(catalog.order, (catalog.names.size + 1) * sizeof(int));
+
+        if (order != NULL) {
+            catalog.order = order;
+            catalog.order_size = 0;
+
+            for (int id = 0; id < catalog.names.size; id++) {
+                if (catalog.entries[id].is_present) {
+                    catalog.order[catalog.order_size++] = id;
+                }
+            }
+
+            qsort(catalog.order, catalog.order_size, sizeof(int), compare_catalog_entries);
+            catalog.is_order_valid = true;
+        }
+    }
+
+    pthread_mutex_unlock(&catalog.mutex);
+
+    return is_loaded;
+}
+
+void scan_catalog_folder() {
+    DIR *dir = opendir(working_folder);
+    struct dirent *entry;
+
+    for (int id = 0; id < catalog.names.size; id++) {
+        catalog.entries[id].is_present = false;
+    }
+
+    catalog.is_order_valid = false;
+
+    if (dir == NULL) {
+        return;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        update_catalog_entry(entry->d_name, true);
+    }
+
+    closedir(dir);
+}
+
+void read_catalog_events() {
+    char events[CATALOG_EVENTS_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t length;
+    bool is_overflowed = false;
+
+    while ((length = read(catalog.inotify_fd, events, sizeof(events))) > 0) {
+        for (char *position = events; position < events + length;) {
+            struct inotify_event *event = (struct inotify_event *) position;
+
+            if (event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                is_overflowed = true;
+            } else if (event->len > 0) {
+                update_catalog_entry(event->name, !(event->mask & (IN_DELETE | IN_MOVED_FROM)));
+            }
+
+            position += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    if (is_overflowed) {
+        scan_catalog_folder();
+    }
+}
+
+void update_catalog_entry(const char *name, bool is_present) {
+    if (name[0] == '.') {
+        return;
+    }
+
+    int id = intern_name(&catalog.names, name);
+
+    if (id == -1) {
+        return;
+    }
+
+    if (id >= catalog.entries_capacity) {
+        int capacity = catalog.entries_capacity ? catalog.entries_capacity * 2 : 64;
+        catalog_entry *entries = (catalog_entry *) realloc(catalog.entries, capacity * sizeof(catalog_entry));
+
+        if (entries == NULL) {
+            return;
+        }
+
+        memset(entries + catalog.entries_capacity, 0, (capacity - catalog.entries_capacity) * sizeof(catalog_entry));
+        catalog.entries = entries;
+        catalog.entries_capacity = capacity;
+    }
+
+    catalog_entry *entry = &catalog.entries[id];
+
+    if (entry->is_present != is_present) {
+        catalog.is_order_valid = false;
+    }
+
+    entry->is_present = is_present;
+    entry->is_stale = is_present;
+}
+
+void scan_catalog_entry(int id) {
+    catalog_entry *entry = &catalog.entries[id];
+    bool is_ordered[NUMBER_OF_SORTS][NUMBER_OF_ORDERS];
+
+    if (entry->records >= 0 && entry->scanned_size == entry->size &&
+        entry->scanned_mtime.tv_sec == entry->mtime.tv_sec && entry->scanned_mtime.tv_nsec == entry->mtime.tv_nsec) {
+        return;
+    }
+
+    char filepath[PATH_SIZE + NAME_MAX];
+    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, catalog.names.names + catalog.names.offsets[id]);
+
+    if ((entry->records = get_file_sort_orders(filepath, is_ordered)) < 0) {
+        return;
+    }
+
+    entry->sort_option = -1;
+
+    for (int sort = NUMBER_OF_SORTS - 1; sort >= 0; sort--) {
+        for (int order = NUMBER_OF_ORDERS - 1; order >= 0; order--) {
+            if (is_ordered[sort][order]) {
+                entry->sort_option = sort;
+                entry->order_option = order;
+            }
+        }
+    }
+
+    entry->scanned_size = entry->size;
+    entry->scanned_mtime = entry->mtime;
+}
+
+long get_file_sort_orders(const char *filepath, bool is_ordered[NUMBER_OF_SORTS][NUMBER_OF_ORDERS]) {
+    overlay_reader reader;
+    int fd = open(filepath, O_RDONLY);
+
+    if (fd == -1 || !init_overlay_reader(&reader, fd, INT_MAX, NULL, 0)) {
+        if (fd != -1) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    long size = get_reader_sort_orders(&reader, is_ordered);
+
+    free_overlay_reader(&reader);
+    close(fd);
+
+    return size;
+}
+
+long get_reader_sort_orders(overlay_reader *reader, bool is_ordered[NUMBER_OF_SORTS][NUMBER_OF_ORDERS]) {
+    record records[2];
+    long size = 0;
+
+    memset(is_ordered, true, NUMBER_OF_SORTS * NUMBER_OF_ORDERS * sizeof(bool));
+
+    while (read_overlay_record(reader, &records[size % 2])) {
+        for (int sort = 0; sort < NUMBER_OF_SORTS && size > 0; sort++) {
+            for (int order = 0; order < NUMBER_OF_ORDERS; order++) {
+                is_ordered[sort][order] = is_ordered[sort][order] &&
+                                          compare_records(&records[(size + 1) % 2], &records[size % 2],
+                                                          sort, order) <= 0;
+            }
+        }
+
+        size++;
+    }
+
+    return size;
+}
+
+bool read_valid_record(record_reader *reader, record *data) {
+    enum record_status status;
+
+    while ((status = read_next_record(reader, data)) != RECORD_END) {
+        if (status == RECORD_OK || status == RECORD_BAD_NAME) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int compare_catalog_entries(const void *first, const void *second) {
+    const catalog_entry *entry1 = &catalog.entries[*(const int *) first];
+    const catalog_entry *entry2 = &catalog.entries[*(const int *) second];
+    int result = 0;
+
+    if (catalog.sort == CATALOG_SIZE_SORT) {
+        result = (entry1->size < entry2->size) - (entry1->size > entry2->size);
+    } else if (catalog.sort == CATALOG_MTIME_SORT) {
+        result = (entry1->mtime.tv_sec < entry2->mtime.tv_sec) - (entry1->mtime.tv_sec > entry2->mtime.tv_sec);
+
+        if (result == 0) {
+            result = (entry1->mtime.tv_nsec < entry2->mtime.tv_nsec) - (entry1->mtime.tv_nsec > entry2->mtime.tv_nsec);
+        }
+    }
+
+    if (result == 0) {
+        result = strcmp(catalog.names.names + catalog.names.offsets[*(const int *) first],
+                        catalog.names.names + catalog.names.offsets[*(const int *) second]);
+    }
+
+    return result;
+}
+
+int browse_catalog(const char *title, char *chosen_name, bool *is_exit) {
+    int current_position = 0, lines = get_terminal_lines();
+    int page_size = lines > CATALOG_PAGE_MIN + 6 ? lines - 6 : CATALOG_PAGE_DEFAULT;
+    bool is_chosen = false;
+
+    *is_exit = false;
+
+    while (!is_chosen && !*is_exit) {
+        if (!refresh_catalog() || catalog.order_size == 0) {
+            return 0;
+        }
+
+        if (current_position >= catalog.order_size) {
+            current_position = catalog.order_size - 1;
+        }
+
+        system("clear");
+        printf("%s\n", title);
+        show_files(current_position, page_size);
+        printf("\nUse "GREEN_BG BLACK_TEXT"WS"BLACK_BG GREEN_TEXT" to move, "
+               GREEN_BG BLACK_TEXT"AD"BLACK_BG GREEN_TEXT" to change the page, "
+               GREEN_BG BLACK_TEXT"O"BLACK_BG GREEN_TEXT" to change the sorting. Press "
+               GREEN_BG BLACK_TEXT"ENTER"BLACK_BG GREEN_TEXT" to choose the file or "
+               GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to exit\n");
+
+        switch (toupper(key_pressed())) {
+            case 'W':
+                current_position -= current_position > 0;
+                break;
+            case 'S':
+                current_position += current_position < catalog.order_size - 1;
+                break;
+            case 'A':
+                current_position = current_position >= page_size ? current_position - page_size : 0;
+                break;
+            case 'D':
+                current_position = current_position + page_size < catalog.order_size ? current_position + page_size
+                                                                                     : catalog.order_size - 1;
+                break;
+            case 'O':
+                pthread_mutex_lock(&catalog.mutex);
+                catalog.sort = (enum catalog_sort) ((catalog.sort + 1) % NUMBER_OF_CATALOG_SORTS);
+                catalog.is_order_valid = false;
+                pthread_mutex_unlock(&catalog.mutex);
+                current_position = 0;
+                break;
+            case '\n':
+                is_chosen = true;
+                break;
+            case EXIT_BUTTON:
+                *is_exit = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (is_chosen) {
+        pthread_mutex_lock(&catalog.mutex);
+        strcpy(chosen_name, catalog.names.names + catalog.names.offsets[catalog.order[current_position]]);
+        pthread_mutex_unlock(&catalog.mutex);
+    }
+
+    return catalog.order_size;
+}
+
+bool init_record_reader(record_reader *reader, int fd) {
+    return init_record_reader_at(reader, fd, 0, -1);
+}
+
+bool init_record_reader_at(record_reader *reader, int fd, off_t offset, off_t limit) {
+    return init_record_reader_range(reader, fd, offset, limit, -1);
+}
+
+bool init_record_reader_range(record_reader *reader, int fd, off_t offset, off_t limit, off_t length) {
+    reader->fd = fd;
+    reader->chunk = NULL;
+    reader->chunk_position = 0;
+    reader->chunk_length = 0;
+    reader->capacity = READ_BUFFER_SIZE;
+    reader->position = 0;
+    reader->length = 0;
+    reader->line_number = 0;
+    reader->line_offset = offset;
+    reader->line_limit = limit;
+    reader->delimiter = '\0';
+    reader->is_eof = false;
+    reader->is_format_checked = offset > 0;
+    reader->is_columnar = false;
+    reader->block = NULL;
+    reader->block_size = 0;
+    reader->block_position = 0;
+    reader->buffer = (char *) malloc(reader->capacity + 1);
+
+    if (reader->buffer != NULL && init_chunk_reader(&reader->io, fd, offset, length)) {
+        return true;
+    }
+
+    free(reader->buffer);
+    reader->buffer = NULL;
+
+    return false;
+}
+
+void free_record_reader(record_reader *reader) {
+    if (reader->buffer != NULL) {
+        free_chunk_reader(&reader->io);
+    }
+
+    free(reader->buffer);
+    free(reader->block);
+    reader->buffer = NULL;
+    reader->block = NULL;
+}
+
+void free_overlay_reader(overlay_reader *reader) {
+    free_record_reader(&reader->reader);
+    free(reader->segments);
+    reader->segments = NULL;
+}
+
+bool init_chunk_reader(chunk_reader *reader, int fd, off_t offset, off_t length) {
+    struct stat file_stat;
+    const char *backend_name = getenv("KP9_IO_BACKEND");
+
+    memset(reader, 0, sizeof(chunk_reader));
+    reader->fd = fd;
+    reader->ring.fd = -1;
+    reader->is_seekable = fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode);
+    reader->length = length >= 0 ? length : reader->is_seekable ? file_stat.st_size : -1;
+    reader->offset = reader->is_seekable ? offset : 0;
+    reader->backend = &pread_backend;
+
+    if (reader->is_seekable && reader->length - reader->offset >= IO_URING_MIN_SIZE &&
+        (backend_name == NULL || strcmp(backend_name, pread_backend.name) != 0)) {
+        reader->backend = &io_uring_backend;
+
+        if (io_uring_backend.open(reader)) {
+            return true;
+        }
+
+        io_uring_backend.close(reader);
+        memset(reader, 0, sizeof(chunk_reader));
+        reader->fd = fd;
+        reader->ring.fd = -1;
+        reader->is_seekable = true;
+        reader->length = length >= 0 ? length : file_stat.st_size;
+        reader->offset = offset;
+        reader->backend = &pread_backend;
+    }
+
+    return pread_backend.open(reader);
+}
+
+ssize_t next_chunk(chunk_reader *reader, char **chunk) {
+    uint64_t start = start_timer();
+    ssize_t length = reader->backend->next(reader, chunk);
+
+    stop_timer(READ_TIMER, start);
+
+    if (length > 0) {
+        add_counter(BYTES_READ_COUNTER, length);
+    }
+
+    return length;
+}
+
+void free_chunk_reader(chunk_reader *reader) {
+    if (reader->backend != NULL) {
+        reader->backend->close(reader);
+        reader->backend = NULL;
+    }
+}
+
+bool pread_open(chunk_reader *reader) {
+    reader->depth = 1;
+
+    if (posix_memalign((void **) &reader->buffers[0], IO_ALIGNMENT, IO_CHUNK_SIZE) != 0) {
+        reader->buffers[0] = NULL;
+        return false;
+    }
+
+    if (reader->is_seekable) {
+        posix_fadvise(reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    return true;
+}
+
+ssize_t pread_next(chunk_reader *reader, char **chunk) {
+    size_t size = IO_CHUNK_SIZE;
+    ssize_t bytes_read;
+
+    if (reader->length >= 0 && reader->length - reader->offset < (off_t) size) {
+        size = reader->length - reader->offset;
+    }
+
+    if (size == 0) {
+        return 0;
+    }
+
+    do {
+        bytes_read = reader->is_seekable ? pread(reader->fd, reader->buffers[0], size, reader->offset)
+                                         : read(reader->fd, reader->buffers[0], size);
+    } while (bytes_read == -1 && errno == EINTR);
+
+    if (bytes_read > 0) {
+        reader->offset += bytes_read;
+    }
+
+    *chunk = reader->buffers[0];
+
+    return bytes_read;
+}
+
+void pread_close(chunk_reader *reader) {
+    free(reader->buffers[0]);
+    reader->buffers[0] = NULL;
+}
+
+int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    int result;
+
+    do {
+        result = (int) syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+    } while (result == -1 && errno == EINTR);
+
+    return result;
+}
+
+bool io_uring_open(chunk_reader *reader) {
+    struct io_uring_params params;
+    io_ring *ring = &reader->ring;
+
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int) syscall(__NR_io_uring_setup, IO_QUEUE_DEPTH, &params);
+
+    if (ring->fd == -1) {
+        return false;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_ring_size > ring->sq_ring_size) {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring->fd, IORING_OFF_SQ_RING);
+
+    if (ring->sq_ring == MAP_FAILED) {
+        ring->sq_ring = NULL;
+        return false;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             ring->fd, IORING_OFF_CQ_RING);
+
+        if (ring->cq_ring == MAP_FAILED) {
+            ring->cq_ring = NULL;
+            return false;
+        }
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *) mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                                              MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        return false;
+    }
+
+    ring->sq_tail = (unsigned *) ((char *) ring->sq_ring + params.sq_off.tail);
+    ring->sq_mask = (unsigned *) ((char *) ring->sq_ring + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *) ((char *) ring->sq_ring + params.sq_off.array);
+    ring->cq_head = (unsigned *) ((char *) ring->cq_ring + params.cq_off.head);
+    ring->cq_tail = (unsigned *) ((char *) ring->cq_ring + params.cq_off.tail);
+    ring->cq_mask = (unsigned *) ((char *) ring->cq_ring + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) ((char *) ring->cq_ring + params.cq_off.cqes);
+
+    reader->depth = IO_QUEUE_DEPTH;
+
+    for (int slot = 0; slot < reader->depth; slot++) {
+        if (posix_memalign((void **) &reader->buffers[slot], IO_ALIGNMENT, IO_CHUNK_SIZE) != 0) {
+            reader->buffers[slot] = NULL;
+            return false;
+        }
+
+        io_uring_submit_read(reader, slot);
+    }
+
+    reader->next_slot = 0;
+    reader->used_slot = -1;
+
+    if (ring->unsubmitted > 0 && io_uring_enter(ring->fd, ring->unsubmitted, 0, 0) < 0) {
+        return false;
+    }
+
+    ring->unsubmitted = 0;
+
+    return true;
+}
+
+void io_uring_submit_read(chunk_reader *reader, int slot) {
+    io_ring *ring = &reader->ring;
+
+    reader->is_submitted[slot] = reader->offset < reader->length;
+    reader->is_done[slot] = false;
+
+    if (!reader->is_submitted[slot]) {
+        return;
+    }
+
+    size_t size = reader->length - reader->offset < IO_CHUNK_SIZE ? reader->length - reader->offset : IO_CHUNK_SIZE;
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = reader->fd;
+    sqe->addr = (uint64_t) (uintptr_t) reader->buffers[slot];
+    sqe->len = (uint32_t) size;
+    sqe->off = (uint64_t) reader->offset;
+    sqe->user_data = (uint64_t) slot;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->unsubmitted++;
+
+    reader->offsets[slot] = reader->offset;
+    reader->sizes[slot] = size;
+    reader->offset += (off_t) size;
+}
+
+void io_uring_reap(chunk_reader *reader) {
+    io_ring *ring = &reader->ring;
+    unsigned head = *ring->cq_head;
+
+    while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        int slot = (int) cqe->user_data;
+
+        reader->results[slot] = cqe->res;
+        reader->is_done[slot] = true;
+        head++;
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+ssize_t io_uring_next(chunk_reader *reader, char **chunk) {
+    io_ring *ring = &reader->ring;
+    int slot = reader->next_slot;
+
+    if (reader->used_slot != -1) {
+        io_uring_submit_read(reader, reader->used_slot);
+        reader->used_slot = -1;
+    }
+
+    if (!reader->is_submitted[slot]) {
+        return 0;
+    }
+
+    io_uring_reap(reader);
+
+    while (!reader->is_done[slot]) {
+        if (io_uring_enter(ring->fd, ring->unsubmitted, 1, IORING_ENTER_GETEVENTS) < 0) {
+            return -1;
+        }
+
+        ring->unsubmitted = 0;
+        io_uring_reap(reader);
+    }
+
+    if (ring->unsubmitted > 0 && io_uring_enter(ring->fd, ring->unsubmitted, 0, 0) >= 0) {
+        ring->unsubmitted = 0;
+    }
+
+    ssize_t bytes_read = reader->results[slot];
+
+    if (bytes_read < 0) {
+        errno = (int) -bytes_read;
+        return -1;
+    }
+
+    while ((size_t) bytes_read < reader->sizes[slot]) {
+        ssize_t rest = pread(reader->fd, reader->buffers[slot] + bytes_read,
+                             reader->sizes[slot] - bytes_read, reader->offsets[slot] + bytes_read);
+
+        if (rest <= 0) {
+            break;
+        }
+
+        bytes_read += rest;
+    }
+
+    reader->used_slot = slot;
+    reader->next_slot = (slot + 1) % reader->depth;
+    *chunk = reader->buffers[slot];
+
+    return bytes_read;
+}
+
+void io_uring_close(chunk_reader *reader) {
+    io_ring *ring = &reader->ring;
+
+    if (ring->fd != -1) {
+        for (int slot = 0; slot < reader->depth; slot++) {
+            while (reader->is_submitted[slot] && !reader->is_done[slot] &&
+                   io_uring_enter(ring->fd, ring->unsubmitted, 1, IORING_ENTER_GETEVENTS) >= 0) {
+                ring->unsubmitted = 0;
+                io_uring_reap(reader);
+            }
+        }
+    }
+
+    if (ring->sqes != NULL) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+
+    if (ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+
+    if (ring->sq_ring != NULL) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+
+    if (ring->fd != -1) {
+        close(ring->fd);
+    }
+
+    for (int slot = 0; slot < IO_QUEUE_DEPTH; slot++) {
+        free(reader->buffers[slot]);
+        reader->buffers[slot] = NULL;
+    }
+
+    memset(ring, 0, sizeof(io_ring));
+    ring->fd = -1;
+}
+
+bool fill_record_reader(record_reader *reader) {
+    if (reader->position > 0) {
+        memmove(reader->buffer, reader->buffer + reader->position, reader->length - reader->position);
+        reader->length -= reader->position;
+        reader->position = 0;
+    }
+
+    if (reader->length == reader->capacity) {
+        char *buffer = (char *) realloc(reader->buffer, reader->capacity * 2 + 1);
+
+        if (buffer == NULL) {
+            printf("Error:" ITALIC_TEXT " Memory reallocation failed"
+                   RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+            return false;
+        }
+
+        reader->buffer = buffer;
+        reader->capacity *= 2;
+    }
+
+    if (reader->chunk_position == reader->chunk_length) {
+        ssize_t bytes_read = next_chunk(&reader->io, &reader->chunk);
+
+        reader->chunk_position = 0;
+        reader->chunk_length = bytes_read > 0 ? bytes_read : 0;
+
+        if (bytes_read <= 0) {
+            reader->is_eof = true;
+            return true;
+        }
+    }
+
+    size_t size = reader->capacity - reader->length;
+
+    if (size > reader->chunk_length - reader->chunk_position) {
+        size = reader->chunk_length - reader->chunk_position;
+    }
+
+    memcpy(reader->buffer + reader->length, reader->chunk + reader->chunk_position, size);
+    reader->chunk_position += size;
+    reader->length += size;
+
+    return true;
+}
+
+bool ensure_bytes(record_reader *reader, size_t size) {
+    while (reader->length - reader->position < size && !reader->is_eof) {
+        if (!fill_record_reader(reader)) {
+            return false;
+        }
+    }
+
+    return reader->length - reader->position >= size;
+}
+
+char *read_line(record_reader *reader) {
+    char *line, *line_end;
+
+    if (reader->line_limit >= 0 && reader->line_offset >= reader->line_limit) {
+        return NULL;
+    }
+
+    while (true) {
+        line_end = memchr(reader->buffer + reader->position, '\n', reader->length - reader->position);
+
+        if (line_end != NULL || reader->is_eof) {
+            break;
+        }
+
+        if (!fill_record_reader(reader)) {
+            return NULL;
+        }
+    }
+
+    if (reader->position == reader->length) {
+        return NULL;
+    }
+
+    line = reader->buffer + reader->position;
+
+    if (line_end == NULL) {
+        line_end = reader->buffer + reader->length;
+    }
+
+    reader->position = line_end - reader->buffer + (line_end < reader->buffer + reader->length);
+    reader->line_offset += (off_t) (reader->buffer + reader->position - line);
+    reader->line_number++;
+
+    if (line_end > line && line_end[-1] == '\r') {
+        line_end--;
+    }
+
+    *line_end = '\0';
+
+    return line;
+}
+
+char detect_delimiter(const char *line) {
+    if (strchr(line, '\t') != NULL) {
+        return '\t';
+    }
+
+    if (strchr(line, ',') != NULL) {
+        return ',';
+    }
+
+    return ' ';
+}
+
+int split_fields(char *line, char delimiter, char **fields, int max_fields) {
+    int count = 0;
+    char *cursor = line;
+
+    while (true) {
+        char *field, *field_end, separator;
+
+        while (*cursor == ' ' || (delimiter == ' ' && *cursor == '\t')) {
+            cursor++;
+        }
+
+        if (delimiter == ' ' && *cursor == '\0') {
+            break;
+        }
+
+        if (count == max_fields) {
+            return count + 1;
+        }
+
+        field = cursor;
+
+        if (*cursor == '"' && delimiter != ' ') {
+            field_end = cursor;
+            cursor++;
+
+            while (*cursor != '\0') {
+                if (*cursor == '"') {
+                    if (cursor[1] != '"') {
+                        cursor++;
+                        break;
+                    }
+                    cursor++;
+                }
+                *field_end++ = *cursor++;
+            }
+
+            while (*cursor != '\0' && *cursor != delimiter) {
+                cursor++;
+            }
+        } else {
+            while (*cursor != '\0' && *cursor != delimiter &&
+                   !(delimiter == ' ' && *cursor == '\t')) {
+                cursor++;
+            }
+
+            field_end = cursor;
+
+            while (field_end > field && field_end[-1] == ' ') {
+                field_end--;
+            }
+        }
+
+        separator = *cursor;
+        *field_end = '\0';
+        fields[count++] = field;
+
+        if (separator == '\0') {
+            break;
+        }
+
+        cursor++;
+    }
+
+    return count;
+}
+
+bool parse_double(const char *text, double *value) {
+    static const double powers_of_ten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                           1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char *cursor = text;
+    bool is_negative = false, is_exact = true;
+    uint64_t mantissa = 0;
+    int digits = 0, fraction_digits = 0;
+
+    if (*cursor == '-' || *cursor == '+') {
+        is_negative = *cursor == '-';
+        cursor++;
+    }
+
+    for (; isdigit((unsigned char) *cursor); cursor++, digits++) {
+        mantissa = mantissa * 10 + (*cursor - '0');
+        is_exact = is_exact && mantissa < (1ULL << 53);
+    }
+
+    if (*cursor == '.') {
+        for (cursor++; isdigit((unsigned char) *cursor); cursor++, digits++, fraction_digits++) {
+            mantissa = mantissa * 10 + (*cursor - '0');
+            is_exact = is_exact && mantissa < (1ULL << 53);
+        }
+    }
+
+    if (*cursor == '\0' && digits > 0 && is_exact && fraction_digits <= 22) {
+        *value = (double) mantissa / powers_of_ten[fraction_digits];
+        *value = is_negative ? -*value : *value;
+        return true;
+    }
+
+    char *end;
+    double result = strtod(text, &end);
+
+    if (end == text || *end != '\0') {
+        return false;
+    }
+
+    *value = result;
+    return true;
+}
+
+bool parse_int(const char *text, int *value) {
+    const char *cursor = text;
+    bool is_negative = false;
+    long long result = 0;
+
+    if (*cursor == '-' || *cursor == '+') {
+        is_negative = *cursor == '-';
+        cursor++;
+    }
+
+    if (!isdigit((unsigned char) *cursor)) {
+        return false;
+    }
+
+    for (; isdigit((unsigned char) *cursor); cursor++) {
+        result = result * 10 + (*cursor - '0');
+
+        if (result > (long long) INT_MAX + 1) {
+            return false;
+        }
+    }
+
+    result = is_negative ? -result : result;
+
+    if (*cursor != '\0' || result > INT_MAX || result < INT_MIN) {
+        return false;
+    }
+
+    *value = (int) result;
+    return true;
+}
+
+enum record_status read_next_record(record_reader *reader, record *data) {
+    char *line, *fields[3];
+    enum record_status status = RECORD_OK;
+
+    if (!reader->is_format_checked) {
+        reader->is_format_checked = true;
+
+        if (ensure_bytes(reader, COLUMNAR_MAGIC_SIZE) &&
+            memcmp(reader->buffer + reader->position, COLUMNAR_MAGIC, COLUMNAR_MAGIC_SIZE) == 0) {
+            reader->position += COLUMNAR_MAGIC_SIZE;
+            reader->is_columnar = true;
+        }
+    }
+
+    while (reader->is_columnar) {
+        if (reader->block_position < reader->block_size) {
+            *data = reader->block[reader->block_position++];
+            reader->line_number++;
+
+            if (data->region_name[0] == '\0' || strpbrk(data->region_name, " \t") != NULL) {
+                return RECORD_BAD_NAME;
+            }
+
+            return RECORD_OK;
+        }
+
+        if (!read_columnar_block(reader)) {
+            return RECORD_BAD_FIELDS;
+        }
+    }
+
+    do {
+        line = read_line(reader);
+
+        if (line == NULL) {
+            return RECORD_END;
+        }
+
+        while (isspace((unsigned char) *line)) {
+            line++;
+        }
+    } while (*line == '\0');
+
+    if (reader->delimiter == '\0') {
+        reader->delimiter = detect_delimiter(line);
+    }
+
+    if (split_fields(line, reader->delimiter, fields, 3) != 3) {
+        return RECORD_BAD_FIELDS;
+    }
+
+    size_t name_length = strlen(fields[0]);
+
+    if (name_length == 0 || name_length > REGION_NAME_MAX - 1 || strpbrk(fields[0], " \t") != NULL) {
+        status = RECORD_BAD_NAME;
+    }
+
+    strncpy(data->region_name, fields[0], REGION_NAME_MAX - 1);
+    data->region_name[REGION_NAME_MAX - 1] = '\0';
+
+    if (!parse_double(fields[1], &data->region_area)) {
+        return RECORD_BAD_AREA;
+    }
+
+    if (!parse_int(fields[2], &data->region_population)) {
+        return RECORD_BAD_POPULATION;
+    }
+
+    return status;
+}
+
+bool read_columnar_block(record_reader *reader) {
+    columnar_header header;
+
+    reader->block_size = 0;
+    reader->block_position = 0;
+
+    if (!ensure_bytes(reader, sizeof(columnar_header))) {
+        reader->is_columnar = false;
+        reader->position = reader->length;
+        return false;
+    }
+
+    memcpy(&header, reader->buffer + reader->position, sizeof(columnar_header));
+    reader->position += sizeof(columnar_header);
+
+    if (header.rows == 0) {
+        reader->is_columnar = false;
+        return true;
+    }
+
+    bool is_valid = header.rows <= COLUMNAR_BLOCK_ROWS &&
+                    header.dictionary_size >= 1 && header.dictionary_size <= header.rows &&
+                    header.payload_size <= header.rows * COLUMNAR_ROW_MAX &&
+                    header.area_digits >= COLUMNAR_AREA_XOR && header.area_digits <= COLUMNAR_AREA_DIGITS &&
+                    ensure_bytes(reader, header.payload_size);
+
+    if (is_valid && reader->block == NULL) {
+        reader->block = (record *) malloc(COLUMNAR_BLOCK_ROWS * sizeof(record));
+    }
+
+    const char *payload = reader->buffer + reader->position;
+
+    is_valid = is_valid && reader->block != NULL &&
+               update_checksum(0, payload, header.payload_size) == header.checksum &&
+               decode_columnar_block(payload, &header, reader->block);
+
+    if (!is_valid) {
+        reader->is_columnar = false;
+        reader->is_eof = true;
+        reader->position = reader->length;
+        return false;
+    }
+
+    reader->position += header.payload_size;
+    reader->block_size = (int) header.rows;
+
+    return true;
+}
+
+bool decode_columnar_block(const char *payload, const columnar_header *header, record *output) {
+    const char *input = payload, *end = payload + header->payload_size;
+    char (*names)[REGION_NAME_MAX] = malloc(header->dictionary_size * sizeof(*names));
+    uint64_t value;
+    bool is_valid = names != NULL;
+
+    for (uint32_t i = 0; i < header->dictionary_size && is_valid; i++) {
+        size_t prefix = 0, length = input < end ? (unsigned char) *input++ : REGION_NAME_MAX;
+
+        if (length >= COLUMNAR_PREFIX_TAG && i > 0 && input < end) {
+            prefix = length - COLUMNAR_PREFIX_TAG;
+            length = (unsigned char) *input++;
+            is_valid = prefix <= strlen(names[i - 1]);
+        }
+
+        is_valid = is_valid && prefix + length <= REGION_NAME_MAX - 1 && (size_t) (end - input) >= length;
+
+        if (is_valid) {
+            memcpy(names[i], names[i > 0 ? i - 1 : 0], prefix);
+            memcpy(names[i] + prefix, input, length);
+            names[i][prefix + length] = '\0';
+            input += length;
+        }
+    }
+
+    for (uint32_t row = 0; row < header->rows && is_valid; row++) {
+        if (header->dictionary_size == header->rows) {
+            value = row;
+        } else {
+            input = read_varint(input, end, &value);
+            is_valid = input != NULL && value < header->dictionary_size;
+        }
+
+        if (is_valid) {
+            strcpy(output[row].region_name, names[value]);
+        }
+    }
+
+    int64_t previous = 0;
+
+    for (uint32_t row = 0; row < header->rows && is_valid; row++) {
+        input = read_varint(input, end, &value);
+        previous += (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+        is_valid = input != NULL && previous >= INT_MIN && previous <= INT_MAX;
+        output[row].region_population = (int) previous;
+    }
+
+    previous = 0;
+
+    for (uint32_t row = 0; row < header->rows && is_valid; row++) {
+        if (header->area_digits != COLUMNAR_AREA_XOR) {
+            input = read_varint(input, end, &value);
+            previous += (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+            output[row].region_area = (double) previous / decimal_scales[header->area_digits];
+            is_valid = input != NULL;
+            continue;
+        }
+
+        uint64_t bits = 0;
+        int control = input < end ? (unsigned char) *input++ : 0xFF;
+        int leading = (control >> 3) & 7, trailing = control & 7, length = 8 - leading - trailing;
+
+        is_valid = control == 0 || ((control & 0x80) && control < 0xC0 && length > 0 && end - input >= length);
+
+        for (int i = 0; i < length && control != 0 && is_valid; i++) {
+            bits = bits << 8 | (unsigned char) *input++;
+        }
+
+        previous ^= (int64_t) (bits << (8 * trailing));
+        memcpy(&output[row].region_area, &previous, sizeof(double));
+    }
+
+    free(names);
+
+    return is_valid && input == end;
+}
+
+enum record_status validate_record(const record *data) {
+    if (!(data->region_area >= area_min && data->region_area <= area_max)) {
+        return RECORD_AREA_OUT_OF_RANGE;
+    }
+
+    if (data->region_population < population_min || data->region_population > population_max) {
+        return RECORD_POPULATION_OUT_OF_RANGE;
+    }
+
+    return RECORD_OK;
+}
+
+bool init_write_buffer(write_buffer *buffer, FILE *file, size_t capacity) {
+    buffer->file = file;
+    buffer->size = 0;
+    buffer->capacity = capacity;
+    buffer->checksum = 0;
+    buffer->written = 0;
+    buffer->data = (char *) malloc(capacity);
+
+    return buffer->data != NULL;
+}
+
+void free_write_buffer(write_buffer *buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+}
+
+bool flush_write_buffer(write_buffer *buffer) {
+    bool is_written = true;
+
+    if (buffer->size > 0) {
+        is_written = fwrite(buffer->data, 1, buffer->size, buffer->file) == buffer->size;
+        add_counter(BYTES_WRITTEN_COUNTER, buffer->size);
+        buffer->checksum = update_checksum(buffer->checksum, buffer->data, buffer->size);
+        buffer->written += buffer->size;
+        buffer->size = 0;
+    }
+
+    return fflush(buffer->file) == 0 && is_written;
+}
+
+bool buffer_reserve(write_buffer *buffer, size_t size) {
+    if (buffer->capacity - buffer->size >= size) {
+        return true;
+    }
+
+    return flush_write_buffer(buffer);
+}
+
+char *format_unsigned(char *output, uint64_t value) {
+    static const char digit_pairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+    char digits[20];
+    int count = 20;
+
+    while (value >= 100) {
+        int pair = (int) (value % 100) * 2;
+        value /= 100;
+        digits[--count] = digit_pairs[pair + 1];
+        digits[--count] = digit_pairs[pair];
+    }
+
+    if (value >= 10) {
+        digits[--count] = digit_pairs[value * 2 + 1];
+        digits[--count] = digit_pairs[value * 2];
+    } else {
+        digits[--count] = (char) ('0' + value);
+    }
+
+    memcpy(output, digits + count, 20 - count);
+
+    return output + 20 - count;
+}
+
+char *format_int(char *output, int value) {
+    if (value < 0) {
+        *output++ = '-';
+        return format_unsigned(output, -(int64_t) value);
+    }
+
+    return format_unsigned(output, value);
+}
+
+binary_float normalize_binary_float(binary_float value) {
+    int shift = __builtin_clzll(value.significand);
+
+    value.significand <<= shift;
+    value.exponent -= shift;
+
+    return value;
+}
+
+binary_float multiply_binary_floats(binary_float first, binary_float second) {
+    unsigned __int128 product = (unsigned __int128) first.significand * second.significand;
+    binary_float result = {(uint64_t) (product >> 64), first.exponent + second.exponent + 64};
+
+    if ((uint64_t) product & (1ULL << 63)) {
+        result.significand++;
+    }
+
+    return result;
+}
+
+binary_float get_cached_power(int exponent, int *decimal_exponent) {
+    static const uint64_t significands[] = {
+            0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+            0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+            0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+            0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+            0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+            0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+            0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+            0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+            0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+            0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+            0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+            0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+            0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+            0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+            0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+            0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+            0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+            0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+            0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+            0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+            0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+            0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+            0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+            0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+            0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+            0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+            0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+            0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+            0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL};
+    static const int16_t exponents[] = {
+            -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927, -901,
+            -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608, -582, -555, -529,
+            -502, -475, -449, -422, -396, -369, -343, -316, -289, -263, -236, -210, -183, -157,
+            -130, -103, -77, -50, -24, 3, 30, 56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322,
+            348, 375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774,
+            800, 827, 853, 880, 907, 933, 960, 986, 1013, 1039, 1066};
+    double estimate = (-61 - exponent) * 0.30102999566398114 + 347;
+    int k = (int) estimate;
+
+    if (estimate - k > 0.0) {
+        k++;
+    }
+
+    int index = (k >> 3) + 1;
+    binary_float power = {significands[index], exponents[index]};
+
+    *decimal_exponent = -(-348 + index * 8);
+
+    return power;
+}
+
+void round_last_digit(char *digits, int length, uint64_t delta, uint64_t rest, uint64_t ten_kappa,
+                      uint64_t distance) {
+    while (rest < distance && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < distance || distance - rest > rest + ten_kappa - distance)) {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+int generate_shortest_digits(double value, char *digits, int *decimal_exponent) {
+    static const uint64_t powers_of_ten[] = {1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+                                             10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+                                             100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+                                             100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+                                             100000000000000000ULL, 1000000000000000000ULL,
+                                             10000000000000000000ULL};
+    uint64_t bits;
+    binary_float number, upper, lower;
+
+    memcpy(&bits, &value, sizeof(bits));
+    number.significand = bits & ((1ULL << 52) - 1);
+    number.exponent = (int) ((bits >> 52) & 0x7FF);
+
+    if (number.exponent != 0) {
+        number.significand += 1ULL << 52;
+        number.exponent -= 1075;
+    } else {
+        number.exponent = -1074;
+    }
+
+    upper = normalize_binary_float((binary_float) {(number.significand << 1) + 1, number.exponent - 1});
+
+    if (number.significand == 1ULL << 52) {
+        lower = (binary_float) {(number.significand << 2) - 1, number.exponent - 2};
+    } else {
+        lower = (binary_float) {(number.significand << 1) - 1, number.exponent - 1};
+    }
+
+    lower.significand <<= lower.exponent - upper.exponent;
+    lower.exponent = upper.exponent;
+
+    binary_float power = get_cached_power(upper.exponent, decimal_exponent);
+    binary_float scaled = multiply_binary_floats(normalize_binary_float(number), power);
+
+    upper = multiply_binary_floats(upper, power);
+    lower = multiply_binary_floats(lower, power);
+    upper.significand--;
+    lower.significand++;
+
+    int shift = -upper.exponent;
+    uint64_t one = 1ULL << shift, delta = upper.significand - lower.significand;
+    uint64_t distance = upper.significand - scaled.significand;
+    uint32_t integral = (uint32_t) (upper.significand >> shift);
+    uint64_t fraction = upper.significand & (one - 1);
+    int kappa = 10, length = 0;
+
+    while (kappa > 1 && integral < powers_of_ten[kappa - 1]) {
+        kappa--;
+    }
+
+    while (kappa > 0) {
+        uint32_t digit = (uint32_t) (integral / powers_of_ten[kappa - 1]);
+
+        integral %= powers_of_ten[kappa - 1];
+        if (digit != 0 || length != 0) {
+            digits[length++] = (char) ('0' + digit);
+        }
+        kappa--;
+
+        uint64_t rest = ((uint64_t) integral << shift) + fraction;
+
+        if (rest <= delta) {
+            *decimal_exponent += kappa;
+            round_last_digit(digits, length, delta, rest, powers_of_ten[kappa] << shift, distance);
+            return length;
+        }
+    }
+
+    while (true) {
+        fraction *= 10;
+        delta *= 10;
+
+        uint32_t digit = (uint32_t) (fraction >> shift);
+
+        if (digit != 0 || length != 0) {
+            digits[length++] = (char) ('0' + digit);
+        }
+        fraction &= one - 1;
+        kappa--;
+
+        if (fraction < delta) {
+            *decimal_exponent += kappa;
+            round_last_digit(digits, length, delta, fraction, one, distance * powers_of_ten[-kappa]);
+            return length;
+        }
+    }
+}
+
+char *format_double(char *output, double value) {
+    char digits[24];
+    int decimal_exponent;
+
+    if (signbit(value)) {
+        *output++ = '-';
+        value = -value;
+    }
+
+    if (value == 0) {
+        *output++ = '0';
+        return output;
+    }
+
+    if (isnan(value) || isinf(value)) {
+        return stpcpy(output, isnan(value) ? "nan" : "inf");
+    }
+
+    int length = generate_shortest_digits(value, digits, &decimal_exponent);
+    int point = length + decimal_exponent;
+
+    if (decimal_exponent >= 0 && point <= 21) {
+        memcpy(output, digits, length);
+        memset(output + length, '0', decimal_exponent);
+        return output + point;
+    }
+
+    if (point > 0 && point <= 21) {
+        memcpy(output, digits, point);
+        output[point] = '.';
+        memcpy(output + point + 1, digits + point, length - point);
+        return output + length + 1;
+    }
+
+    if (point > -6 && point <= 0) {
+        *output++ = '0';
+        *output++ = '.';
+        memset(output, '0', -point);
+        memcpy(output - point, digits, length);
+        return output - point + length;
+    }
+
+    *output++ = digits[0];
+    if (length > 1) {
+        *output++ = '.';
+        memcpy(output, digits + 1, length - 1);
+        output += length - 1;
+    }
+    *output++ = 'e';
+
+    return format_int(output, point - 1);
+}
+
+bool buffer_write_record(write_buffer *buffer, const record *data) {
+    if (!buffer_reserve(buffer, RECORD_LINE_MAX)) {
+        return false;
+    }
+
+    char *output = buffer->data + buffer->size;
+    size_t name_length = strlen(data->region_name);
+
+    memcpy(output, data->region_name, name_length);
+    output += name_length;
+    *output++ = ' ';
+    output = format_double(output, data->region_area);
+    *output++ = ' ';
+    output = format_int(output, data->region_population);
+    *output++ = '\n';
+
+    buffer->size = output - buffer->data;
+
+    return true;
+}
+
+bool buffer_write_export(write_buffer *buffer, const record *data, enum export_format format) {
+    if (!buffer_reserve(buffer, RECORD_LINE_MAX)) {
+        return false;
+    }
+
+    char *output = buffer->data + buffer->size;
+    int32_t population = data->region_population;
+
+    switch (format) {
+        case CSV_FORMAT:
+            if (strpbrk(data->region_name, ",\"") != NULL) {
+                *output++ = '"';
+                for (const char *symbol = data->region_name; *symbol != '\0'; symbol++) {
+                    if (*symbol == '"') {
+                        *output++ = '"';
+                    }
+                    *output++ = *symbol;
+                }
+                *output++ = '"';
+            } else {
+                output = stpcpy(output, data->region_name);
+            }
+            *output++ = ',';
+            output = format_double(output, data->region_area);
+            *output++ = ',';
+            output = format_int(output, data->region_population);
+            *output++ = '\n';
+            break;
+        case JSON_LINES_FORMAT:
+            output = stpcpy(output, "{\"region_name\":\"");
+            for (const char *symbol = data->region_name; *symbol != '\0'; symbol++) {
+                if (*symbol == '"' || *symbol == '\\') {
+                    *output++ = '\\';
+                    *output++ = *symbol;
+                } else if ((unsigned char) *symbol < 0x20) {
+                    output += sprintf(output, "\\u%04x", *symbol);
+                } else {
+                    *output++ = *symbol;
+                }
+            }
+            output = stpcpy(output, "\",\"region_area\":");
+            output = format_double(output, data->region_area);
+            output = stpcpy(output, ",\"region_population\":");
+            output = format_int(output, data->region_population);
+            output = stpcpy(output, "}\n");
+            break;
+        case BINARY_FORMAT:
+            memset(output, 0, REGION_NAME_MAX + 1);
+            memcpy(output, data->region_name, strlen(data->region_name));
+            output += REGION_NAME_MAX + 1;
+            memcpy(output, &data->region_area, sizeof(double));
+            output += sizeof(double);
+            memcpy(output, &population, sizeof(int32_t));
+            output += sizeof(int32_t);
+            break;
+        default:
+            return false;
+    }
+
+    buffer->size = output - buffer->data;
+
+    return true;
+}
+
+bool matches_filter(const record *data, const record_filter *filter) {
+    return strncmp(data->region_name, filter->name_prefix, strlen(filter->name_prefix)) == 0 &&
+           data->region_area >= filter->min_area && data->region_area <= filter->max_area &&
+           data->region_population >= filter->min_population &&
+           data->region_population <= filter->max_population;
+}
+
+void init_checksum_table() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t value = i;
+
+        for (int bit = 0; bit < 8; bit++) {
+            value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+        }
+
+        checksum_table[i] = value;
+    }
+}
+
+uint32_t update_checksum(uint32_t checksum, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *) data;
+
+    pthread_once(&checksum_table_once, init_checksum_table);
+
+    checksum = ~checksum;
+
+    for (size_t i = 0; i < size; i++) {
+        checksum = checksum_table[(checksum ^ bytes[i]) & 0xFF] ^ (checksum >> 8);
+    }
+
+    return ~checksum;
+}
+
+uint32_t hash_name(const char *name) {
+    uint32_t hash = 2166136261u;
+
+    for (const char *symbol = name; *symbol != '\0'; symbol++) {
+        hash = (hash ^ (unsigned char) *symbol) * 16777619u;
+    }
+
+    return hash;
+}
+
+bool init_name_pool(name_pool *pool, int expected_size) {
+    memset(pool, 0, sizeof(name_pool));
+
+    pool->capacity = expected_size > 16 ? expected_size : 16;
+    pool->names_capacity = (size_t) pool->capacity * 8;
+    pool->slots_capacity = 32;
+
+    while (pool->slots_capacity < pool->capacity * 2) {
+        pool->slots_capacity *= 2;
+    }
+
+    pool->names = (char *) malloc(pool->names_capacity);
+    pool->offsets = (uint32_t *) malloc(pool->capacity * sizeof(uint32_t));
+    pool->slots = (int *) malloc(pool->slots_capacity * sizeof(int));
+
+    if (pool->names == NULL || pool->offsets == NULL || pool->slots == NULL) {
+        free_name_pool(pool);
+        return false;
+    }
+
+    memset(pool->slots, -1, pool->slots_capacity * sizeof(int));
+
+    return true;
+}
+
+void clear_name_pool(name_pool *pool) {
+    pool->size = 0;
+    pool->names_size = 0;
+    memset(pool->slots, -1, pool->slots_capacity * sizeof(int));
+}
+
+void free_name_pool(name_pool *pool) {
+    free(pool->names);
+    free(pool->offsets);
+    free(pool->ranks);
+    free(pool->slots);
+    memset(pool, 0, sizeof(name_pool));
+}
+
+bool grow_name_pool(name_pool *pool) {
+    int capacity = pool->capacity * 2, slots_capacity = pool->slots_capacity * 2;
+    uint32_t *offsets = (uint32_t *) realloc(pool->offsets, capacity * sizeof(uint32_t));
+
+    if (offsets == NULL) {
+        return false;
+    }
+
+    pool->offsets = offsets;
+    pool->capacity = capacity;
+
+    int *slots = (int *) malloc(slots_capacity * sizeof(int));
+
+    if (slots == NULL) {
+        return false;
+    }
+
+    memset(slots, -1, slots_capacity * sizeof(int));
+
+    for (int id = 0; id < pool->size; id++) {
+        uint32_t slot = hash_name(pool->names + pool->offsets[id]) & (slots_capacity - 1);
+
+        while (slots[slot] != -1) {
+            slot = (slot + 1) & (slots_capacity - 1);
+        }
+
+        slots[slot] = id;
+    }
+
+    free(pool->slots);
+    pool->slots = slots;
+    pool->slots_capacity = slots_capacity;
+
+    return true;
+}
+
+int intern_name(name_pool *pool, const char *name) {
+    uint32_t slot = hash_name(name) & (pool->slots_capacity - 1);
+
+    while (pool->slots[slot] != -1) {
+        if (strcmp(pool->names + pool->offsets[pool->slots[slot]], name) == 0) {
+            return pool->slots[slot];
+        }
+
+        slot = (slot + 1) & (pool->slots_capacity - 1);
+    }
+
+    size_t length = strlen(name) + 1;
+
+    if (pool->names_size + length > pool->names_capacity) {
+        size_t names_capacity = pool->names_capacity * 2 + length;
+        char *names = (char *) realloc(pool->names, names_capacity);
+
+        if (names == NULL) {
+            return -1;
+        }
+
+        pool->names = names;
+        pool->names_capacity = names_capacity;
+    }
+
+    if (pool->size >= pool->capacity || pool->size * 2 >= pool->slots_capacity) {
+        if (!grow_name_pool(pool)) {
+            return -1;
+        }
+
+        return intern_name(pool, name);
+    }
+
+    memcpy(pool->names + pool->names_size, name, length);
+    pool->offsets[pool->size] = (uint32_t) pool->names_size;
+    pool->names_size += length;
+    pool->slots[slot] = pool->size;
+
+    return pool->size++;
+}
+
+int compare_pool_entries(const void *first, const void *second) {
+    return strcmp(((const pool_entry *) first)->name, ((const pool_entry *) second)->name);
+}
+
+bool rank_name_pool(name_pool *pool) {
+    pool_entry *entries = (pool_entry *) malloc(pool->size * sizeof(pool_entry) + 1);
+
+    free(pool->ranks);
+    pool->ranks = (uint32_t *) malloc(pool->size * sizeof(uint32_t) + 1);
+
+    if (entries == NULL || pool->ranks == NULL) {
+        free(entries);
+        return false;
+    }
+
+    for (int id = 0; id < pool->size; id++) {
+        entries[id].name = pool->names + pool->offsets[id];
+        entries[id].id = id;
+    }
+
+    qsort(entries, pool->size, sizeof(pool_entry), compare_pool_entries);
+
+    for (int rank = 0; rank < pool->size; rank++) {
+        pool->ranks[entries[rank].id] = (uint32_t) rank;
+    }
+
+    free(entries);
+
+    return true;
+}
+
+char *write_varint(char *output, uint64_t value) {
+    while (value >= 0x80) {
+        *output++ = (char) (value | 0x80);
+        value >>= 7;
+    }
+
+    *output++ = (char) value;
+
+    return output;
+}
+
+const char *read_varint(const char *input, const char *end, uint64_t *value) {
+    *value = 0;
+
+    for (int shift = 0; input != NULL && input < end && shift < 64; shift += 7) {
+        unsigned char byte = (unsigned char) *input++;
+
+        *value |= (uint64_t) (byte & 0x7F) << shift;
+
+        if (!(byte & 0x80)) {
+            return input;
+        }
+    }
+
+    return NULL;
+}
+
+int get_area_digits(const record *rows, int size) {
+    for (int digits = 0; digits <= COLUMNAR_AREA_DIGITS; digits++) {
+        bool is_exact = true;
+
+        for (int i = 0; i < size && is_exact; i++) {
+            double value = rows[i].region_area, scaled = value * decimal_scales[digits];
+
+            is_exact = scaled > -1e15 && scaled < 1e15 && !(value == 0 && signbit(value)) &&
+                       (double) llround(scaled) / decimal_scales[digits] == value;
+        }
+
+        if (is_exact) {
+            return digits;
+        }
+    }
+
+    return COLUMNAR_AREA_XOR;
+}
+
+bool init_columnar_writer(columnar_writer *writer, write_buffer *buffer) {
+    writer->buffer = buffer;
+    writer->size = 0;
+    writer->rows = (record *) malloc(COLUMNAR_BLOCK_ROWS * sizeof(record));
+    writer->ids = (int *) malloc(COLUMNAR_BLOCK_ROWS * sizeof(int));
+
+    if (init_name_pool(&writer->pool, COLUMNAR_BLOCK_ROWS) && writer->rows != NULL && writer->ids != NULL) {
+        return true;
+    }
+
+    free_columnar_writer(writer);
+
+    return false;
+}
+
+void free_columnar_writer(columnar_writer *writer) {
+    free(writer->rows);
+    free(writer->ids);
+    free_name_pool(&writer->pool);
+    writer->rows = NULL;
+    writer->ids = NULL;
+}
+
+bool add_columnar_record(columnar_writer *writer, const record *data) {
+    writer->rows[writer->size++] = *data;
+
+    return writer->size < COLUMNAR_BLOCK_ROWS || flush_columnar_block(writer);
+}
+
+bool flush_columnar_block(columnar_writer *writer) {
+    columnar_header header = {0};
+
+    if (writer->size == 0) {
+        return true;
+    }
+
+    if (!buffer_reserve(writer->buffer, sizeof(columnar_header) + writer->size * COLUMNAR_ROW_MAX)) {
+        return false;
+    }
+
+    clear_name_pool(&writer->pool);
+
+    for (int row = 0; row < writer->size; row++) {
+        if ((writer->ids[row] = intern_name(&writer->pool, writer->rows[row].region_name)) == -1) {
+            return false;
+        }
+    }
+
+    header.dictionary_size = (uint32_t) writer->pool.size;
+
+    char *payload = writer->buffer->data + writer->buffer->size + sizeof(columnar_header);
+    char *output = payload;
+
+    const char *previous_name = "";
+
+    for (uint32_t i = 0; i < header.dictionary_size; i++) {
+        const char *name = writer->pool.names + writer->pool.offsets[i];
+        size_t prefix = 0, length = strnlen(name, REGION_NAME_MAX - 1);
+
+        while (prefix < length && name[prefix] == previous_name[prefix]) {
+            prefix++;
+        }
+
+        if (prefix >= 2) {
+            *output++ = (char) (COLUMNAR_PREFIX_TAG + prefix);
+        } else {
+            prefix = 0;
+        }
+
+        *output++ = (char) (length - prefix);
+        memcpy(output, name + prefix, length - prefix);
+        output += length - prefix;
+        previous_name = name;
+    }
+
+    for (int row = 0; row < writer->size && header.dictionary_size < (uint32_t) writer->size; row++) {
+        output = write_varint(output, writer->ids[row]);
+    }
+
+    int64_t previous = 0;
+
+    for (int row = 0; row < writer->size; row++) {
+        int64_t delta = (int64_t) writer->rows[row].region_population - previous;
+
+        output = write_varint(output, ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63));
+        previous = writer->rows[row].region_population;
+    }
+
+    header.area_digits = get_area_digits(writer->rows, writer->size);
+    previous = 0;
+
+    for (int row = 0; row < writer->size; row++) {
+        int64_t value;
+
+        if (header.area_digits != COLUMNAR_AREA_XOR) {
+            value = llround(writer->rows[row].region_area * decimal_scales[header.area_digits]);
+
+            int64_t delta = value - previous;
+            output = write_varint(output, ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63));
+            previous = value;
+            continue;
+        }
+
+        memcpy(&value, &writer->rows[row].region_area, sizeof(double));
+
+        uint64_t bits = (uint64_t) (value ^ previous);
+        previous = value;
+
+        if (bits == 0) {
+            *output++ = 0;
+            continue;
+        }
+
+        int leading = __builtin_clzll(bits) / 8, trailing = __builtin_ctzll(bits) / 8;
+
+        *output++ = (char) (0x80 | leading << 3 | trailing);
+
+        for (int i = 7 - leading; i >= trailing; i--) {
+            *output++ = (char) (bits >> (8 * i));
+        }
+    }
+
+    header.rows = (uint32_t) writer->size;
+    header.payload_size = (uint32_t) (output - payload);
+    header.checksum = update_checksum(0, payload, header.payload_size);
+
+    memcpy(payload - sizeof(columnar_header), &header, sizeof(columnar_header));
+    writer->buffer->size = output - writer->buffer->data;
+    writer->size = 0;
+
+    return true;
+}
+
+bool finish_columnar_writer(columnar_writer *writer) {
+    columnar_header header = {0};
+
+    if (!flush_columnar_block(writer) || !buffer_reserve(writer->buffer, sizeof(columnar_header))) {
+        return false;
+    }
+
+    memcpy(writer->buffer->data + writer->buffer->size, &header, sizeof(columnar_header));
+    writer->buffer->size += sizeof(columnar_header);
+
+    return true;
+}
+
+bool get_file_checksum(int fd, uint64_t length, uint32_t *checksum) {
+    chunk_reader reader;
+    uint64_t offset = 0;
+    ssize_t bytes_read;
+    char *chunk;
+
+    *checksum = 0;
+
+    if (length == 0) {
+        return true;
+    }
+
+    if (!init_chunk_reader(&reader, fd, 0, (off_t) length)) {
+        return false;
+    }
+
+    while ((bytes_read = next_chunk(&reader, &chunk)) > 0) {
+        *checksum = update_checksum(*checksum, chunk, bytes_read);
+        offset += bytes_read;
+    }
+
+    free_chunk_reader(&reader);
+
+    return offset == length;
+}
+
+void get_sidecar_filepath(char *filepath, size_t size, const char *file_name, const char *extension) {
+    snprintf(filepath, size, "%s/.%s.%s", working_folder, file_name, extension);
+}
+
+void sync_working_folder() {
+    int fd = open(working_folder, O_RDONLY | O_DIRECTORY);
+
+    if (fd != -1) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+void get_view_extension(char *extension, size_t size, const sort_keys *keys) {
+    snprintf(extension, size, "%s-%s.view", sort_option_names[keys->sorts[0]],
+             keys->orders[0] == ASCENDING_ORDER ? "asc" : "desc");
+}
+
+uint32_t *load_record_view(const char *file_name, const sort_keys *keys, const wal_header *base, int size) {
+    char filepath[PATH_SIZE + NAME_MAX], extension[32];
+    view_header header;
+    uint32_t *permutation = NULL;
+    bool is_valid;
+
+    get_view_extension(extension, sizeof(extension), keys);
+    get_sidecar_filepath(filepath, sizeof(filepath), file_name, extension);
+
+    int fd = open(filepath, O_RDONLY);
+
+    if (fd == -1) {
+        return NULL;
+    }
+
+    is_valid = read(fd, &header, sizeof(view_header)) == sizeof(view_header) &&
+               memcmp(header.magic, VIEW_MAGIC, VIEW_MAGIC_SIZE) == 0 &&
+               header.base_checksum == base->base_checksum && header.base_length == base->base_length &&
+               header.size >= 0 && (size < 0 || header.size == size);
+
+    if (is_valid) {
+        permutation = (uint32_t *) malloc(header.size * sizeof(uint32_t) + 1);
+        is_valid = permutation != NULL &&
+                   read(fd, permutation, header.size * sizeof(uint32_t)) == (ssize_t) (header.size * sizeof(uint32_t));
+        add_counter(BYTES_READ_COUNTER, sizeof(view_header) + header.size * sizeof(uint32_t));
+    }
+
+    for (int i = 0; i < header.size && is_valid; i++) {
+        is_valid = permutation[i] < (uint32_t) header.size;
+    }
+
+    close(fd);
+
+    if (!is_valid) {
+        free(permutation);
+        return NULL;
+    }
+
+    return permutation;
+}
+
+bool save_record_view(const char *file_name, const sort_keys *keys, const wal_header *base,
+                      const uint32_t *permutation, int size) {
+    char filepath[PATH_SIZE + NAME_MAX], temp_filepath[PATH_SIZE + NAME_MAX], extension[32], temp_extension[64];
+    view_header header = {.base_checksum = base->base_checksum, .size = size, .base_length = base->base_length};
+
+    memcpy(header.magic, VIEW_MAGIC, VIEW_MAGIC_SIZE);
+    get_view_extension(extension, sizeof(extension), keys);
+    snprintf(temp_extension, sizeof(temp_extension), "%s.%ld.tmp", extension, (long) getpid());
+    get_sidecar_filepath(filepath, sizeof(filepath), file_name, extension);
+    get_sidecar_filepath(temp_filepath, sizeof(temp_filepath), file_name, temp_extension);
+
+    int fd = open(temp_filepath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if (fd == -1) {
+        return false;
+    }
+
+    bool is_written = write_all(fd, (const char *) &header, sizeof(view_header)) &&
+                      write_all(fd, (const char *) permutation, size * sizeof(uint32_t));
+
+    add_counter(BYTES_WRITTEN_COUNTER, sizeof(view_header) + size * sizeof(uint32_t));
+    is_written = close(fd) == 0 && is_written;
+    is_written = is_written && rename(temp_filepath, filepath) == 0;
+
+    if (!is_written) {
+        remove(temp_filepath);
+    }
+
+    return is_written;
+}
+
+bool patch_record_view(const uint32_t *view, int view_size, const wal_entry *entries, int count,
+                       record **data, int size, const sort_keys *keys, uint32_t *patched) {
+    int *origins = (int *) malloc((view_size + count + 1) * sizeof(int));
+    int *positions = (int *) malloc((view_size + 1) * sizeof(int));
+    int *changed = (int *) malloc((size + 1) * sizeof(int));
+    record **changed_data = (record **) malloc((size + 1) * sizeof(record *));
+    uint32_t *changed_order = (uint32_t *) malloc((size + 1) * sizeof(uint32_t));
+    int current = view_size, num_of_changed = 0;
+    bool is_patched = origins != NULL && positions != NULL && changed != NULL &&
+                      changed_data != NULL && changed_order != NULL;
+
+    for (int i = 0; i < view_size && is_patched; i++) {
+        origins[i] = i;
+        positions[i] = -1;
+    }
+
+    for (int i = 0; i < count && is_patched; i++) {
+        int position = entries[i].operation == WAL_APPEND ? current : entries[i].position;
+
+        switch (entries[i].operation) {
+            case WAL_APPEND:
+            case WAL_INSERT:
+                is_patched = position >= 0 && position <= current;
+
+                if (is_patched) {
+                    memmove(origins + position + 1, origins + position, (current - position) * sizeof(int));
+                    origins[position] = -1;
+                    current++;
+                }
+                break;
+            case WAL_DELETE:
+                is_patched = position >= 0 && position < current;
+
+                if (is_patched) {
+                    memmove(origins + position, origins + position + 1, (current - position - 1) * sizeof(int));
+                    current--;
+                }
+                break;
+            case WAL_EDIT:
+                is_patched = position >= 0 && position < current;
+
+                if (is_patched) {
+                    origins[position] = -1;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    is_patched = is_patched && current == size;
+
+    for (int i = 0; i < size && is_patched; i++) {
+        if (origins[i] >= 0) {
+            positions[origins[i]] = i;
+        } else {
+            changed[num_of_changed] = i;
+            changed_data[num_of_changed++] = data[i];
+        }
+    }
+
+    is_patched = is_patched && sort_record_permutation(changed_data, num_of_changed, keys, changed_order);
+
+    if (is_patched) {
+        int i = 0, j = 0, k = 0;
+
+        while (k < size) {
+            while (i < view_size && positions[view[i]] < 0) {
+                i++;
+            }
+
+            int survivor = i < view_size ? positions[view[i]] : -1;
+            int inserted = j < num_of_changed ? changed[changed_order[j]] : -1;
+            int comparison_result = survivor == -1 || inserted == -1
+                                    ? 0 : compare_records_by_keys(data[survivor], data[inserted], keys);
+
+            if (inserted == -1 || (survivor != -1 && (comparison_result < 0 ||
+                                                      (comparison_result == 0 && survivor < inserted)))) {
+                patched[k++] = (uint32_t) survivor;
+                i++;
+            } else {
+                patched[k++] = (uint32_t) inserted;
+                j++;
+            }
+        }
+    }
+
+    free(origins);
+    free(positions);
+    free(changed);
+    free(changed_data);
+    free(changed_order);
+
+    return is_patched;
+}
+
+int get_base_size(const wal_entry *entries, int count, int size) {
+    for (int i = count - 1; i >= 0; i--) {
+        size += (entries[i].operation == WAL_DELETE) -
+                (entries[i].operation == WAL_APPEND || entries[i].operation == WAL_INSERT);
+    }
+
+    return size;
+}
+
+void update_record_views(const char *file_name, const wal_header *base, const wal_entry *entries, int count,
+                         record **data, int size) {
+    int view_size = get_base_size(entries, count, size);
+
+    for (int sort = 0; sort < NUMBER_OF_SORTS; sort++) {
+        for (int order = 0; order < NUMBER_OF_ORDERS; order++) {
+            sort_keys keys = {1, {sort}, {order}};
+            uint32_t *view = load_record_view(file_name, &keys, base, view_size);
+            uint32_t *patched = view == NULL ? NULL : (uint32_t *) malloc(size * sizeof(uint32_t) + 1);
+
+            if (patched != NULL && patch_record_view(view, view_size, entries, count, data, size, &keys, patched)) {
+                save_record_view(file_name, &keys, &working_log->header, patched, size);
+            }
+
+            free(view);
+            free(patched);
+        }
+    }
+}
+
+void remove_record_views(const char *file_name) {
+    char filepath[PATH_SIZE + NAME_MAX], extension[32];
+
+    for (int sort = 0; sort < NUMBER_OF_SORTS; sort++) {
+        for (int order = 0; order < NUMBER_OF_ORDERS; order++) {
+            sort_keys keys = {1, {sort}, {order}};
+
+            get_view_extension(extension, sizeof(extension), &keys);
+            get_sidecar_filepath(filepath, sizeof(filepath), file_name, extension);
+            remove(filepath);
+        }
+    }
+}
+
+void init_line_index(line_index *index) {
+    memset(index, 0, sizeof(line_index));
+    memcpy(index->header.magic, LINE_INDEX_MAGIC, LINE_INDEX_MAGIC_SIZE);
+    index->header.stride = LINE_INDEX_STRIDE;
+}
+
+void free_line_index(line_index *index) {
+    free(index->offsets);
+    init_line_index(index);
+}
+
+bool add_line_offset(line_index *index, uint64_t offset) {
+    if (index->header.records % index->header.stride == 0) {
+        if (index->header.size >= index->capacity) {
+            int capacity = index->capacity ? index->capacity * 2 : 64;
+            uint64_t *offsets = (uint64_t *) realloc(index->offsets, capacity * sizeof(uint64_t));
+
+            if (offsets == NULL) {
+                return false;
+            }
+
+            index->offsets = offsets;
+            index->capacity = capacity;
+        }
+
+        index->offsets[index->header.size++] = offset;
+    }
+
+    index->header.records++;
+
+    return true;
+}
+
+bool scan_line_index(line_index *index, int fd, off_t offset) {
+    record_reader reader;
+    record input_data;
+    enum record_status status;
+
+    if (!init_record_reader_at(&reader, fd, offset, -1)) {
+        return false;
+    }
+
+    reader.delimiter = ' ';
+
+    bool is_indexed = true;
+    off_t line_offset = reader.line_offset;
+
+    while (is_indexed && (status = read_next_record(&reader, &input_data)) != RECORD_END) {
+        if (reader.is_columnar) {
+            is_indexed = false;
+            break;
+        }
+
+        if (status == RECORD_OK || status == RECORD_BAD_NAME) {
+            is_indexed = add_line_offset(index, (uint64_t) line_offset);
+        }
+
+        line_offset = reader.line_offset;
+    }
+
+    free_record_reader(&reader);
+
+    return is_indexed;
+}
+
+bool load_line_index(const char *file_name, const wal_header *base, line_index *index) {
+    char filepath[PATH_SIZE + NAME_MAX];
+    line_index_header header;
+
+    init_line_index(index);
+    get_sidecar_filepath(filepath, sizeof(filepath), file_name, "idx");
+
+    int fd = open(filepath, O_RDONLY);
+
+    if (fd == -1) {
+        return false;
+    }
+
+    bool is_valid = read(fd, &header, sizeof(header)) == sizeof(header) &&
+                    memcmp(header.magic, LINE_INDEX_MAGIC, LINE_INDEX_MAGIC_SIZE) == 0 &&
+                    header.base_checksum == base->base_checksum && header.base_length == base->base_length &&
+                    header.stride == LINE_INDEX_STRIDE && header.records >= 0 &&
+                    header.size == (header.records + header.stride - 1) / header.stride;
+
+    if (is_valid) {
+        index->offsets = (uint64_t *) malloc(header.size * sizeof(uint64_t) + 1);
+        is_valid = index->offsets != NULL &&
+                   read(fd, index->offsets, header.size * sizeof(uint64_t)) ==
+                   (ssize_t) (header.size * sizeof(uint64_t));
+        add_counter(BYTES_READ_COUNTER, sizeof(header) + header.size * sizeof(uint64_t));
+    }
+
+    close(fd);
+
+    if (!is_valid) {
+        free_line_index(index);
+        return false;
+    }
+
+    index->header = header;
+    index->capacity = header.size;
+
+    return true;
+}
+
+bool save_line_index(const char *file_name, const wal_header *base, const line_index *index) {
+    char filepath[PATH_SIZE + NAME_MAX], temp_filepath[PATH_SIZE + NAME_MAX], temp_extension[32];
+    line_index_header header = index->header;
+
+    if (header.base_checksum != base->base_checksum || header.base_length != base->base_length) {
+        header.data_device = 0;
+        header.data_inode = 0;
+        header.data_mtime = 0;
+    }
+
+    header.base_checksum = base->base_checksum;
+    header.base_length = base->base_length;
+    snprintf(temp_extension, sizeof(temp_extension), "idx.%ld.tmp", (long) getpid());
+    get_sidecar_filepath(filepath, sizeof(filepath), file_name, "idx");
+    get_sidecar_filepath(temp_filepath, sizeof(temp_filepath), file_name, temp_extension);
+
+    int fd = open(temp_filepath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if (fd == -1) {
+        return false;
+    }
+
+    bool is_written = write_all(fd, (const char *) &header, sizeof(header)) &&
+                      write_all(fd, (const char *) index->offsets, header.size * sizeof(uint64_t));
+
+    add_counter(BYTES_WRITTEN_COUNTER, sizeof(header) + header.size * sizeof(uint64_t));
+    is_written = close(fd) == 0 && is_written;
+    is_written = is_written && rename(temp_filepath, filepath) == 0;
+
+    if (!is_written) {
+        remove(temp_filepath);
+    }
+
+    return is_written;
+}
+
+bool is_line_index_stamped(const char *file_name, const wal_header *base, const struct stat *data_stat) {
+    char filepath[PATH_SIZE + NAME_MAX];
+    line_index_header header;
+
+    get_sidecar_filepath(filepath, sizeof(filepath), file_name, "idx");
+
+    int fd = open(filepath, O_RDONLY);
+
+    if (fd == -1) {
+        return false;
+    }
+
+    bool is_stamped = read(fd, &header, sizeof(header)) == sizeof(header) &&
+                      memcmp(header.magic, LINE_INDEX_MAGIC, LINE_INDEX_MAGIC_SIZE) == 0 &&
+                      header.base_checksum == base->base_checksum && header.base_length == base->base_length &&
+                      header.base_length == (uint64_t) data_stat->st_size && header.data_mtime != 0 &&
+                      header.data_device == (uint64_t) data_stat->st_dev &&
+                      header.data_inode == (uint64_t) data_stat->st_ino &&
+                      header.data_mtime == (int64_t) data_stat->st_mtim.tv_sec * 1000000000 +
+                                           data_stat->st_mtim.tv_nsec;
+
+    close(fd);
+
+    return is_stamped;
+}
+
+void stamp_line_index(const char *file_name, const wal_header *base, const struct stat *data_stat) {
+    char filepath[PATH_SIZE + NAME_MAX];
+    line_index_header header;
+    struct timespec now;
+
+    get_sidecar_filepath(filepath, sizeof(filepath), file_name, "idx");
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    int fd = open(filepath, O_RDWR);
+
+    if (fd == -1) {
+        return;
+    }
+
+    if (data_stat->st_mtim.tv_sec < now.tv_sec &&
+        pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+        memcmp(header.magic, LINE_INDEX_MAGIC, LINE_INDEX_MAGIC_SIZE) == 0 &&
+        header.base_checksum == base->base_checksum && header.base_length == base->base_length &&
+        header.base_length == (uint64_t) data_stat->st_size) {
+        header.data_device = (uint64_t) data_stat->st_dev;
+        header.data_inode = (uint64_t) data_stat->st_ino;
+        header.data_mtime = (int64_t) data_stat->st_mtim.tv_sec * 1000000000 + data_stat->st_mtim.tv_nsec;
+
+        if (pwrite(fd, &header, sizeof(header), 0) == sizeof(header)) {
+            add_counter(BYTES_WRITTEN_COUNTER, sizeof(header));
+        }
+    }
+
+    close(fd);
+}
+
+bool get_line_index(FILE *working_file, const char *file_name, line_index *index) {
+    if (working_log->fd == -1 || working_file != working_log->data_file) {
+        return false;
+    }
+
+    if (index->offsets != NULL && index->header.base_checksum == working_log->header.base_checksum &&
+        index->header.base_length == working_log->header.base_length) {
+        return true;
+    }
+
+    free_line_index(index);
+
+    if (load_line_index(file_name, &working_log->header, index)) {
+        return true;
+    }
+
+    uint64_t span = begin_span();
+
+    fflush(working_file);
+
+    bool is_indexed = scan_line_index(index, fileno(working_file), 0);
+
+    end_span("build line index", span);
+
+    if (!is_indexed) {
+        free_line_index(index);
+        return false;
+    }
+
+    if (index->offsets == NULL) {
+        index->offsets = (uint64_t *) malloc(sizeof(uint64_t));
+    }
+
+    index->header.base_checksum = working_log->header.base_checksum;
+    index->header.base_length = working_log->header.base_length;
+    save_line_index(file_name, &working_log->header, index);
+
+    return index->offsets != NULL;
+}
+
+void extend_line_index(const char *file_name, const wal_header *base, int fd) {
+    line_index index;
+
+    if (!load_line_index(file_name, base, &index)) {
+        return;
+    }
+
+    if (scan_line_index(&index, fd, (off_t) base->base_length)) {
+        save_line_index(file_name, &working_log->header, &index);
+    }
+
+    free_line_index(&index);
+}
+
+int read_indexed_records(int fd, const line_index *index, int first, int count, record *data) {
+    record_reader reader;
+    record input_data;
+    enum record_status status;
+    int skipped = first % index->header.stride, size = 0;
+    int last = (first + count - 1) / index->header.stride + 1;
+
+    if (first < 0 || first >= index->header.records ||
+        !init_record_reader_range(&reader, fd, (off_t) index->offsets[first / index->header.stride], -1,
+                                  last < index->header.size ? (off_t) index->offsets[last] : -1)) {
+        return 0;
+    }
+
+    reader.delimiter = ' ';
+
+    while (size < count && (status = read_next_record(&reader, &input_data)) != RECORD_END) {
+        if (status != RECORD_OK && status != RECORD_BAD_NAME) {
+            continue;
+        }
+
+        if (skipped > 0) {
+            skipped--;
+            continue;
+        }
+
+        data[size++] = input_data;
+    }
+
+    free_record_reader(&reader);
+
+    return size;
+}
+
+int get_current_records(const line_index *index) {
+    int size = index->header.records;
+
+    for (int i = 0; i < working_log->size; i++) {
+        switch (working_log->entries[i].operation) {
+            case WAL_APPEND:
+            case WAL_INSERT:
+                size++;
+                break;
+            case WAL_DELETE:
+                size--;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return size;
+}
+
+int resolve_base_position(int position, int size, const record **overlay) {
+    *overlay = NULL;
+
+    for (int i = working_log->size - 1; i >= 0; i--) {
+        const wal_entry *entry = &working_log->entries[i];
+        int inserted;
+
+        switch (entry->operation) {
+            case WAL_APPEND:
+            case WAL_INSERT:
+                size--;
+                inserted = entry->operation == WAL_APPEND ? size : entry->position;
+
+                if (position == inserted) {
+                    *overlay = &entry->new_record;
+                    return -1;
+                }
+
+                position -= position > inserted;
+                break;
+            case WAL_DELETE:
+                size++;
+                position += position >= entry->position;
+                break;
+            case WAL_EDIT:
+                if (position == entry->position) {
+                    *overlay = &entry->new_record;
+                    return -1;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return position;
+}
+
+int read_current_records(int fd, const line_index *index, int first, int count, record *data) {
+    int size = get_current_records(index), low = -1, high = -1, read = 0;
+    const record *overlay;
+
+    if (first + count > size) {
+        count = size - first;
+    }
+
+    if (first < 0 || count <= 0) {
+        return 0;
+    }
+
+    int *positions = (int *) malloc(count * sizeof(int));
+
+    if (positions == NULL) {
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        positions[i] = resolve_base_position(first + i, size, &overlay);
+
+        if (overlay != NULL) {
+            data[i] = *overlay;
+        } else {
+            low = low == -1 ? positions[i] : low;
+            high = positions[i];
+        }
+    }
+
+    if (low != -1) {
+        record *base = (record *) malloc((high - low + 1) * sizeof(record));
+
+        read = base != NULL ? read_indexed_records(fd, index, low, high - low + 1, base) : 0;
+
+        for (int i = 0; i < count && read == high - low + 1; i++) {
+            if (positions[i] != -1) {
+                data[i] = base[positions[i] - low];
+            }
+        }
+
+        free(base);
+    }
+
+    free(positions);
+
+    return low == -1 || read == high - low + 1 ? count : -1;
+}
+
+int count_base_records(FILE *working_file, const char *file_name) {
+    line_index index;
+    record_reader reader;
+    record input_data;
+    int records = -1;
+
+    init_line_index(&index);
+
+    if (get_line_index(working_file, file_name, &index)) {
+        records = index.header.records;
+    }
+
+    free_line_index(&index);
+
+    if (records == -1 && init_record_reader(&reader, fileno(working_file))) {
+        reader.delimiter = ' ';
+
+        for (records = 0; read_valid_record(&reader, &input_data); records++) {
+        }
+
+        free_record_reader(&reader);
+    }
+
+    return records;
+}
+
+int split_overlay_segment(overlay_reader *reader, int position) {
+    int start = 0;
+
+    for (int i = 0; i < reader->size; i++) {
+        overlay_segment *segment = &reader->segments[i];
+
+        if (position == start) {
+            return i;
+        }
+
+        if (position < start + segment->length) {
+            overlay_segment tail = *segment;
+
+            tail.first += position - start;
+            tail.length -= position - start;
+            segment->length = position - start;
+            memmove(segment + 2, segment + 1, (reader->size - i - 1) * sizeof(overlay_segment));
+            reader->segments[i + 1] = tail;
+            reader->size++;
+            return i + 1;
+        }
+
+        start += segment->length;
+    }
+
+    return position == start ? reader->size : -1;
+}
+
+bool init_overlay_reader(overlay_reader *reader, int fd, int records, const wal_entry *entries, int count) {
+    int current = records;
+    bool is_valid = true;
+
+    memset(reader, 0, sizeof(overlay_reader));
+    reader->segments = (overlay_segment *) malloc((2 * count + 1) * sizeof(overlay_segment));
+
+    if (reader->segments == NULL) {
+        return false;
+    }
+
+    reader->segments[0] = (overlay_segment) {.first = 0, .length = records};
+    reader->size = records > 0;
+
+    for (int i = 0; i < count && is_valid; i++) {
+        int position = entries[i].operation == WAL_APPEND ? current : entries[i].position, index;
+        overlay_segment changed = {.length = 1, .is_changed = true, .data = entries[i].new_record};
+
+        switch (entries[i].operation) {
+            case WAL_APPEND:
+            case WAL_INSERT:
+                index = position >= 0 && position <= current ? split_overlay_segment(reader, position) : -1;
+                is_valid = index != -1;
+
+                if (is_valid) {
+                    memmove(reader->segments + index + 1, reader->segments + index,
+                            (reader->size - index) * sizeof(overlay_segment));
+                    reader->segments[index] = changed;
+                    reader->size++;
+                    current++;
+                }
+                break;
+            case WAL_DELETE:
+            case WAL_EDIT:
+                index = position >= 0 && position < current ? split_overlay_segment(reader, position) : -1;
+                is_valid = index != -1 && split_overlay_segment(reader, position + 1) != -1;
+
+                if (is_valid && entries[i].operation == WAL_EDIT) {
+                    reader->segments[index] = changed;
+                } else if (is_valid) {
+                    memmove(reader->segments + index, reader->segments + index + 1,
+                            (reader->size - index - 1) * sizeof(overlay_segment));
+                    reader->size--;
+                    current--;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (!is_valid || !init_record_reader(&reader->reader, fd)) {
+        free(reader->segments);
+        reader->segments = NULL;
+        return false;
+    }
+
+    reader->reader.delimiter = ' ';
+
+    return true;
+}
+
+bool init_current_reader(overlay_reader *reader, FILE *working_file, const char *file_name) {
+    int records = INT_MAX;
+
+    fflush(working_file);
+
+    if (working_log->size > 0 && working_file == working_log->data_file) {
+        records = count_base_records(working_file, file_name);
+    }
+
+    if (records < 0) {
+        return false;
+    }
+
+    return init_overlay_reader(reader, fileno(working_file), records,
+                               working_file == working_log->data_file ? working_log->entries : NULL,
+                               working_file == working_log->data_file ? working_log->size : 0);
+}
+
+bool read_overlay_record(overlay_reader *reader, record *data) {
+    while (reader->segment < reader->size) {
+        const overlay_segment *segment = &reader->segments[reader->segment];
+
+        if (reader->offset == segment->length) {
+            reader->segment++;
+            reader->offset = 0;
+            continue;
+        }
+
+        if (segment->is_changed) {
+            *data = segment->data;
+            reader->offset++;
+            return true;
+        }
+
+        while (reader->base_position < segment->first + reader->offset) {
+            if (!read_valid_record(&reader->reader, data)) {
+                return false;
+            }
+            reader->base_position++;
+        }
+
+        if (!read_valid_record(&reader->reader, data)) {
+            return false;
+        }
+
+        reader->base_position++;
+        reader->offset++;
+        return true;
+    }
+
+    return false;
+}
+
+int find_indexed_move_position(int fd, const line_index *index, int size, int old_position,
+                               const record *new_record, const sort_keys *keys) {
+    record current;
+
+    if ((old_position == 0 || (read_current_records(fd, index, old_position - 1, 1, &current) == 1 &&
+                               compare_records_by_keys(&current, new_record, keys) <= 0)) &&
+        (old_position == size - 1 || (read_current_records(fd, index, old_position + 1, 1, &current) == 1 &&
+                                      compare_records_by_keys(new_record, &current, keys) <= 0))) {
+        return old_position;
+    }
+
+    int low = 0, high = size - 1;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+
+        if (read_current_records(fd, index, middle < old_position ? middle : middle + 1, 1, &current) != 1) {
+            return old_position;
+        }
+
+        if (compare_records_by_keys(&current, new_record, keys) > 0) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    return low;
+}
+
+bool is_same_sort_keys(const sort_keys *keys1, const sort_keys *keys2) {
+    bool is_same = keys1->size == keys2->size;
+
+    for (int i = 0; i < keys1->size && is_same; i++) {
+        is_same = keys1->sorts[i] == keys2->sorts[i] && keys1->orders[i] == keys2->orders[i];
+    }
+
+    return is_same;
+}
+
+bool load_sorted_prefix(const char *file_name, const wal_header *base, const wal_entry *entries, int count,
+                        sort_keys *keys, int *prefix) {
+    char filepath[PATH_SIZE + NAME_MAX];
+    sorted_prefix_header header;
+    bool is_valid;
+
+    get_sidecar_filepath(filepath, sizeof(filepath), file_name, "sorted");
+
+    int fd = open(filepath, O_RDONLY);
+
+    if (fd == -1) {
+        return false;
+    }
+
+    is_valid = read(fd, &header, sizeof(header)) == sizeof(header) &&
+               memcmp(header.magic, SORTED_PREFIX_MAGIC, SORTED_PREFIX_MAGIC_SIZE) == 0 &&
+               header.base_checksum == base->base_checksum && header.base_length == base->base_length &&
+               header.prefix >= 0 && header.keys_size >= 1 && header.keys_size <= NUMBER_OF_SORTS &&
+               header.entries >= 0 && header.entries <= count;
+    close(fd);
+
+    keys->size = 0;
+
+    for (int i = 0; i < header.keys_size && is_valid; i++) {
+        is_valid = header.sorts[i] >= 0 && header.sorts[i] < NUMBER_OF_SORTS &&
+                   header.orders[i] >= 0 && header.orders[i] < NUMBER_OF_ORDERS &&
+                   add_sort_key(keys, header.sorts[i], header.orders[i]);
+    }
+
+    *prefix = is_valid ? replay_sorted_prefix(header.prefix, entries + header.entries, count - header.entries) : 0;
+
+    return is_valid;
+}
+
+bool save_sorted_prefix(const char *file_name, const wal_header *base, const sort_keys *keys, int prefix) {
+    char filepath[PATH_SIZE + NAME_MAX], temp_filepath[PATH_SIZE + NAME_MAX], temp_extension[32];
+    sorted_prefix_header header = {.base_checksum = base->base_checksum, .prefix = prefix,
+                                   .base_length = base->base_length, .keys_size = keys->size,
+                                   .entries = working_log->size};
+
+    memcpy(header.magic, SORTED_PREFIX_MAGIC, SORTED_PREFIX_MAGIC_SIZE);
+
+    for (int i = 0; i < keys->size; i++) {
+        header.sorts[i] = keys->sorts[i];
+        header.orders[i] = keys->orders[i];
+    }
+
+    snprintf(temp_extension, sizeof(temp_extension), "sorted.%ld.tmp", (long) getpid());
+    get_sidecar_filepath(filepath, sizeof(filepath), file_name, "sorted");
+    get_sidecar_filepath(temp_filepath, sizeof(temp_filepath), file_name, temp_extension);
+
+    int fd = open(temp_filepath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if (fd == -1) {
+        return false;
+    }
+
+    bool is_written = write_all(fd, (const char *) &header, sizeof(header));
+
+    is_written = close(fd) == 0 && is_written;
+    is_written = is_written && rename(temp_filepath, filepath) == 0;
+
+    if (!is_written) {
+        remove(temp_filepath);
+    }
+
+    return is_written;
+}
+
+int replay_sorted_prefix(int prefix, const wal_entry *entries, int count) {
+    for (int i = 0; i < count; i++) {
+        switch (entries[i].operation) {
+            case WAL_DELETE:
+                prefix -= entries[i].position < prefix;
+                break;
+            case WAL_INSERT:
+            case WAL_EDIT:
+                if (entries[i].position < prefix) {
+                    prefix = entries[i].position;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return prefix;
+}
+
+int extend_sorted_prefix(record **data, int size, const sort_keys *keys, int prefix) {
+    if (prefix > size) {
+        prefix = size;
+    }
+
+    if (prefix == 0 && size > 0) {
+        prefix = 1;
+    }
+
+    while (prefix < size && compare_records_by_keys(data[prefix - 1], data[prefix], keys) <= 0) {
+        prefix++;
+    }
+
+    return prefix;
+}
+
+void update_sorted_prefix(const char *file_name, const wal_header *base, const wal_entry *entries, int count,
+                          record **data, int size) {
+    sort_keys keys;
+    int prefix;
+
+    if (!load_sorted_prefix(file_name, base, entries, count, &keys, &prefix)) {
+        return;
+    }
+
+    if (data != NULL) {
+        prefix = extend_sorted_prefix(data, size, &keys, prefix);
+    }
+
+    save_sorted_prefix(file_name, &working_log->header, &keys, prefix);
+}
+
+int resort_records(const char *file_name, record **data, int size, const sort_keys *keys) {
+    sort_keys tracked_keys;
+    int prefix = 0;
+
+    if (!load_sorted_prefix(file_name, &working_log->header, working_log->entries, working_log->size,
+                            &tracked_keys, &prefix) || !is_same_sort_keys(&tracked_keys, keys)) {
+        prefix = 0;
+    }
+
+    prefix = extend_sorted_prefix(data, size, keys, prefix);
+
+    if (prefix == size) {
+        return 0;
+    }
+
+    record **merged = (record **) malloc(size * sizeof(record *));
+
+    if (merged == NULL) {
+        sort_records_by_keys(data, size, keys);
+        return size;
+    }
+
+    sort_records_by_keys(data + prefix, size - prefix, keys);
+
+    uint64_t span = begin_span();
+    int i = 0, j = prefix, k = 0;
+
+    while (i < prefix && j < size) {
+        merged[k++] = compare_records_by_keys(data[j], data[i], keys) < 0 ? data[j++] : data[i++];
+    }
+
+    while (i < prefix) {
+        merged[k++] = data[i++];
+    }
+
+    while (j < size) {
+        merged[k++] = data[j++];
+    }
+
+    memcpy(data, merged, size * sizeof(record *));
+    free(merged);
+    end_span("merge sorted tail", span);
+
+    return size - prefix;
+}
+
+bool reset_working_log(uint32_t base_checksum, uint64_t base_length) {
+    if (working_log->fd == -1) {
+        return false;
+    }
+
+    memset(&working_log->header, 0, sizeof(wal_header));
+    memcpy(working_log->header.magic, WAL_MAGIC, WAL_MAGIC_SIZE);
+    working_log->header.base_checksum = base_checksum;
+    working_log->header.base_length = base_length;
+    working_log->size = 0;
+    working_log->unsynced = 0;
+    add_counter(BYTES_WRITTEN_COUNTER, sizeof(wal_header));
+    add_counter(FSYNCS_COUNTER, 2);
+
+    return ftruncate(working_log->fd, sizeof(wal_header)) == 0 && fdatasync(working_log->fd) == 0 &&
+           pwrite(working_log->fd, &working_log->header, sizeof(wal_header), 0) == sizeof(wal_header) &&
+           fdatasync(working_log->fd) == 0;
+}
+
+bool commit_working_log() {
+    if (working_log->fd == -1 || working_log->unsynced == 0) {
+        return true;
+    }
+
+    add_counter(FSYNCS_COUNTER, 1);
+
+    if (fdatasync(working_log->fd) != 0) {
+        return false;
+    }
+
+    working_log->unsynced = 0;
+
+    return true;
+}
+
+bool reserve_wal_entries(int count) {
+    if (working_log->size + count > working_log->capacity) {
+        int capacity = working_log->capacity ? working_log->capacity : WAL_GROUP_COMMIT_SIZE;
+
+        while (capacity < working_log->size + count) {
+            capacity *= 2;
+        }
+
+        wal_entry *entries = (wal_entry *) realloc(working_log->entries, capacity * sizeof(wal_entry));
+
+        if (entries == NULL) {
+            return false;
+        }
+
+        working_log->entries = entries;
+        working_log->capacity = capacity;
+    }
+
+    return true;
+}
+
+bool add_wal_entry(const wal_entry *entry) {
+    if (working_log->size >= working_log->capacity) {
+        int capacity = working_log->capacity ? working_log->capacity * 2 : WAL_GROUP_COMMIT_SIZE;
+        wal_entry *entries = (wal_entry *) realloc(working_log->entries, capacity * sizeof(wal_entry));
+
+        if (entries == NULL) {
+            return false;
+        }
+
+        working_log->entries = entries;
+        working_log->capacity = capacity;
+    }
+
+    working_log->entries[working_log->size++] = *entry;
+
+    return true;
+}
+
+wal_entry make_wal_entry(enum wal_operation operation, int position, int size,
+                         const record *old_record, const record *new_record) {
+    wal_entry entry;
+
+    memset(&entry, 0, sizeof(wal_entry));
+    entry.operation = operation;
+    entry.position = position;
+    entry.size = size;
+
+    if (old_record != NULL) {
+        entry.old_record = *old_record;
+    }
+
+    if (new_record != NULL) {
+        entry.new_record = *new_record;
+    }
+
+    entry.checksum = update_checksum(0, (char *) &entry + sizeof(uint32_t), sizeof(wal_entry) - sizeof(uint32_t));
+
+    return entry;
+}
+
+bool log_record_change(const wal_entry *entry) {
+    return log_record_changes(entry, 1);
+}
+
+bool log_record_changes(const wal_entry *entries, int count) {
+    if (working_log->fd == -1) {
+        return false;
+    }
+
+    lock_working_log(LOCK_EX);
+    refresh_working_log(working_log->data_file);
+
+    off_t offset = (off_t) (sizeof(wal_header) + working_log->size * sizeof(wal_entry));
+    ssize_t length = (ssize_t) (count * sizeof(wal_entry));
+    bool is_logged = reserve_wal_entries(count) && pwrite(working_log->fd, entries, length, offset) == length;
+
+    add_counter(BYTES_WRITTEN_COUNTER, length);
+
+    for (int i = 0; i < count && is_logged; i++) {
+        add_wal_entry(&entries[i]);
+    }
+
+    unlock_working_log();
+
+    if (!is_logged) {
+        return false;
+    }
+
+    working_log->unsynced += count;
+
+    if (working_log->unsynced >= WAL_GROUP_COMMIT_SIZE) {
+        commit_working_log();
+    }
+
+    return true;
+}
+
+bool apply_wal_entry(record ***data, int *size, int *capacity, const wal_entry *entry) {
+    int position = entry->operation == WAL_APPEND ? *size : entry->position;
+
+    switch (entry->operation) {
+        case WAL_APPEND:
+        case WAL_INSERT:
+            if (position < 0 || position > *size) {
+                return false;
+            }
+
+            if (*size >= *capacity) {
+                int new_capacity = *capacity ? *capacity * 2 : 2;
+                record **new_data = (record **) realloc(*data, new_capacity * sizeof(record *));
+
+                if (new_data == NULL) {
+                    return false;
+                }
+
+                *data = new_data;
+                *capacity = new_capacity;
+            }
+
+            record *new_record = (record *) malloc(sizeof(record));
+            add_counter(ALLOCATIONS_COUNTER, 1);
+
+            if (new_record == NULL) {
+                return false;
+            }
+
+            *new_record = entry->new_record;
+            memmove(*data + position + 1, *data + position, (*size - position) * sizeof(record *));
+            (*data)[position] = new_record;
+            (*size)++;
+            return true;
+        case WAL_DELETE:
+            if (position < 0 || position >= *size) {
+                return false;
+            }
+
+            free((*data)[position]);
+            memmove(*data + position, *data + position + 1, (*size - position - 1) * sizeof(record *));
+            (*size)--;
+            return true;
+        case WAL_EDIT:
+            if (position < 0 || position >= *size) {
+                return false;
+            }
+
+            *(*data)[position] = entry->new_record;
+            return true;
+        default:
+            return true;
+    }
+}
+
+bool is_valid_wal_entry(const wal_entry *entry) {
+    return entry->checksum == update_checksum(0, (const char *) entry + sizeof(uint32_t),
+                                              sizeof(wal_entry) - sizeof(uint32_t));
+}
+
+bool is_same_record(const record *record1, const record *record2) {
+    return strcmp(record1->region_name, record2->region_name) == 0 &&
+           record1->region_area == record2->region_area &&
+           record1->region_population == record2->region_population;
+}
+
+void lock_working_log(int operation) {
+    if (working_log->fd == -1) {
+        return;
+    }
+
+    if (working_log->lock_depth == 0 || (operation == LOCK_EX && working_log->lock_mode != LOCK_EX)) {
+        while (flock(working_log->fd, operation) == -1 && errno == EINTR) {
+        }
+        working_log->lock_mode = operation;
+    }
+
+    working_log->lock_depth++;
+}
+
+void unlock_working_log() {
+    if (working_log->fd == -1 || working_log->lock_depth == 0) {
+        return;
+    }
+
+    if (--working_log->lock_depth == 0) {
+        flock(working_log->fd, LOCK_UN);
+        working_log->lock_mode = LOCK_UN;
+    }
+}
+
+bool refresh_working_log(FILE *working_file) {
+    struct stat path_stat, file_stat;
+    wal_header header;
+    wal_entry entry;
+    bool is_changed = false;
+
+    if (working_log->fd == -1 || working_file != working_log->data_file) {
+        return false;
+    }
+
+    if (stat(working_log->data_path, &path_stat) == 0 && fstat(fileno(working_file), &file_stat) == 0 &&
+        (path_stat.st_dev != file_stat.st_dev || path_stat.st_ino != file_stat.st_ino)) {
+        int fd = open(working_log->data_path, O_RDWR | O_APPEND);
+
+        if (fd != -1) {
+            fflush(working_file);
+            dup2(fd, fileno(working_file));
+            close(fd);
+            fseek(working_file, 0, SEEK_SET);
+            working_log->size = 0;
+            is_changed = true;
+        }
+    }
+
+    if (pread(working_log->fd, &header, sizeof(wal_header), 0) == sizeof(wal_header) &&
+        memcmp(&header, &working_log->header, sizeof(wal_header)) != 0) {
+        working_log->header = header;
+        working_log->size = 0;
+        is_changed = true;
+    }
+
+    off_t offset = (off_t) (sizeof(wal_header) + working_log->size * sizeof(wal_entry));
+
+    while (pread(working_log->fd, &entry, sizeof(wal_entry), offset) == sizeof(wal_entry) &&
+           is_valid_wal_entry(&entry) && add_wal_entry(&entry)) {
+        offset += sizeof(wal_entry);
+        is_changed = true;
+    }
+
+    if (is_changed) {
+        working_log->unsynced = 0;
+    }
+
+    return is_changed;
+}
+
+void remove_temp_files(const char *file_name) {
+    DIR *dir = opendir(working_folder);
+    struct dirent *entry;
+
+    if (dir == NULL) {
+        return;
+    }
+
+    char prefix[PATH_SIZE], filepath[PATH_SIZE + NAME_MAX];
+    snprintf(prefix, sizeof(prefix), ".%s.", file_name);
+
+    size_t prefix_length = strlen(prefix);
+
+    while ((entry = readdir(dir)) != NULL) {
+        size_t length = strlen(entry->d_name);
+
+        if (length > prefix_length + 4 && strncmp(entry->d_name, prefix, prefix_length) == 0 &&
+            strcmp(entry->d_name + length - 4, ".tmp") == 0) {
+            snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, entry->d_name);
+            remove(filepath);
+        }
+    }
+
+    closedir(dir);
+}
+
+FILE *checkpoint_working_file(FILE *working_file, char *working_file_name, record **data, int size) {
+    write_buffer buffer;
+    line_index index;
+    bool is_written, is_indexed = true;
+    uint64_t start = start_timer();
+
+    char filepath[PATH_SIZE + NAME_MAX], temp_filepath[PATH_SIZE + NAME_MAX], temp_extension[32];
+    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, working_file_name);
+    snprintf(temp_extension, sizeof(temp_extension), "%ld.tmp", (long) getpid());
+    get_sidecar_filepath(temp_filepath, sizeof(temp_filepath), working_file_name, temp_extension);
+
+    lock_working_log(LOCK_EX);
+
+    FILE *temp_file = fopen(temp_filepath, "w");
+
+    if (temp_file == NULL || !init_write_buffer(&buffer, temp_file, WRITE_BUFFER_SIZE)) {
+        printf("Error:" ITALIC_TEXT " Can't create temporary file"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        if (temp_file != NULL) {
+            fclose(temp_file);
+        }
+        unlock_working_log();
+        stop_timer(REWRITE_TIMER, start);
+        return working_file;
+    }
+
+    uint64_t span = begin_span();
+
+    is_written = true;
+
+    init_line_index(&index);
+
+    for (int i = 0; i < size && is_written; i++) {
+        is_indexed = is_indexed && add_line_offset(&index, buffer.written + buffer.size);
+        is_written = buffer_write_record(&buffer, data[i]);
+    }
+
+    is_written = flush_write_buffer(&buffer) && is_written;
+    is_written = fsync(fileno(temp_file)) == 0 && is_written;
+    add_counter(FSYNCS_COUNTER, 1);
+
+    long length = ftell(temp_file);
+
+    free_write_buffer(&buffer);
+
+    is_written = fclose(temp_file) == 0 && is_written;
+    end_span("write temp file", span);
+
+    span = begin_span();
+    is_written = is_written && rename(temp_filepath, filepath) == 0;
+    end_span("rename", span);
+
+    if (!is_written) {
+        printf("Error:" ITALIC_TEXT " Can't replace the file with temporary file"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        remove(temp_filepath);
+        free_line_index(&index);
+        unlock_working_log();
+        stop_timer(REWRITE_TIMER, start);
+        return working_file;
+    }
+
+    sync_working_folder();
+    fclose(working_file);
+
+    working_file = fopen(filepath, "a+");
+    working_log->data_file = working_file;
+    reset_working_log(buffer.checksum, length);
+    working_log->checkpoints++;
+
+    if (is_indexed && working_log->fd != -1) {
+        save_line_index(working_file_name, &working_log->header, &index);
+    }
+
+    free_line_index(&index);
+
+    unlock_working_log();
+
+    stop_timer(REWRITE_TIMER, start);
+
+    return working_file;
+}
+
+FILE *rewrite_matching_records(FILE *working_file, char *working_file_name, const record_filter *filter,
+                               const record_update *update, int *scanned, int *changed, bool *is_saved) {
+    write_buffer buffer;
+    line_index index;
+    record_reader reader;
+    record input_data;
+    enum record_status status;
+    sort_keys keys;
+    int prefix = 0, sorted_prefix = 0;
+    uint64_t start = start_timer();
+
+    *scanned = 0;
+    *changed = 0;
+    *is_saved = false;
+
+    char filepath[PATH_SIZE + NAME_MAX], temp_filepath[PATH_SIZE + NAME_MAX], temp_extension[32];
+    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, working_file_name);
+    snprintf(temp_extension, sizeof(temp_extension), "%ld.tmp", (long) getpid());
+    get_sidecar_filepath(temp_filepath, sizeof(temp_filepath), working_file_name, temp_extension);
+
+    lock_working_log(LOCK_EX);
+
+    working_file = flush_working_log(working_file, working_file_name, 1);
+
+    bool is_tracked = load_sorted_prefix(working_file_name, &working_log->header, working_log->entries,
+                                         working_log->size, &keys, &prefix);
+
+    fflush(working_file);
+
+    FILE *temp_file = fopen(temp_filepath, "w");
+
+    if (temp_file == NULL || !init_write_buffer(&buffer, temp_file, WRITE_BUFFER_SIZE)) {
+        printf("Error:" ITALIC_TEXT " Can't create temporary file"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        if (temp_file != NULL) {
+            fclose(temp_file);
+            remove(temp_filepath);
+        }
+        unlock_working_log();
+        stop_timer(REWRITE_TIMER, start);
+        return working_file;
+    }
+
+    bool is_written = init_record_reader(&reader, fileno(working_file)), is_indexed = true;
+
+    init_line_index(&index);
+
+    reader.delimiter = ' ';
+
+    while (is_written && (status = read_next_record(&reader, &input_data)) != RECORD_END) {
+        if (status != RECORD_OK && status != RECORD_BAD_NAME) {
+            continue;
+        }
+
+        int position = (*scanned)++;
+
+        if (matches_filter(&input_data, filter)) {
+            (*changed)++;
+
+            if (update == NULL) {
+                continue;
+            }
+
+            apply_record_update(&input_data, update);
+
+            if (position < prefix) {
+                prefix = position;
+            }
+        }
+
+        if (position < prefix) {
+            sorted_prefix++;
+        }
+
+        is_indexed = is_indexed && add_line_offset(&index, buffer.written + buffer.size);
+        is_written = buffer_write_record(&buffer, &input_data);
+    }
+
+    free_record_reader(&reader);
+
+    is_written = flush_write_buffer(&buffer) && is_written;
+    is_written = fsync(fileno(temp_file)) == 0 && is_written;
+    add_counter(FSYNCS_COUNTER, 1);
+
+    long length = ftell(temp_file);
+
+    free_write_buffer(&buffer);
+
+    is_written = fclose(temp_file) == 0 && is_written;
+
+    if (*changed == 0 && is_written) {
+        remove(temp_filepath);
+        free_line_index(&index);
+        unlock_working_log();
+        stop_timer(REWRITE_TIMER, start);
+        *is_saved = true;
+        return working_file;
+    }
+
+    is_written = is_written && rename(temp_filepath, filepath) == 0;
+
+    if (!is_written) {
+        printf("Error:" ITALIC_TEXT " Can't replace the file with temporary file"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        remove(temp_filepath);
+        free_line_index(&index);
+        unlock_working_log();
+        stop_timer(REWRITE_TIMER, start);
+        return working_file;
+    }
+
+    sync_working_folder();
+    fclose(working_file);
+
+    working_file = fopen(filepath, "a+");
+    working_log->data_file = working_file;
+    reset_working_log(buffer.checksum, length);
+    working_log->checkpoints++;
+
+    if (is_tracked) {
+        save_sorted_prefix(working_file_name, &working_log->header, &keys, sorted_prefix);
+    }
+
+    if (is_indexed) {
+        save_line_index(working_file_name, &working_log->header, &index);
+    }
+
+    free_line_index(&index);
+
+    unlock_working_log();
+
+    stop_timer(REWRITE_TIMER, start);
+
+    *is_saved = true;
+
+    return working_file;
+}
+
+FILE *flush_working_log(FILE *working_file, char *working_file_name, int min_entries) {
+    int size = 0;
+
+    if (working_file == NULL) {
+        return working_file;
+    }
+
+    lock_working_log(LOCK_EX);
+    refresh_working_log(working_file);
+
+    if (working_log->size == 0 || working_log->size < min_entries) {
+        unlock_working_log();
+        return working_file;
+    }
+
+    record **data = get_records_arr(working_file, &size);
+
+    if (data != NULL) {
+        wal_header base = working_log->header;
+        int count = working_log->size;
+        uint64_t checkpoints = working_log->checkpoints;
+        wal_entry *entries = (wal_entry *) malloc(count * sizeof(wal_entry));
+
+        if (entries != NULL) {
+            memcpy(entries, working_log->entries, count * sizeof(wal_entry));
+        }
+
+        working_file = checkpoint_working_file(working_file, working_file_name, data, size);
+
+        if (entries != NULL && working_log->checkpoints != checkpoints) {
+            update_record_views(working_file_name, &base, entries, count, data, size);
+            update_sorted_prefix(working_file_name, &base, entries, count, data, size);
+        }
+
+        free(entries);
+        free_records_arr(data, size);
+    }
+
+    unlock_working_log();
+
+    return working_file;
+}
+
+FILE *save_record_change(FILE *working_file, char *working_file_name, record ***data, int *size,
+                         enum wal_operation operation, int position,
+                         const record *old_record, const record *new_record, bool *is_saved) {
+    int capacity = *size, current_size = 0;
+
+    lock_working_log(LOCK_EX);
+
+    if (refresh_working_log(working_file)) {
+        record **current_data = get_records_arr(working_file, &current_size);
+
+        *is_saved = current_data != NULL && current_size == *size &&
+                    (old_record == NULL || is_same_record(current_data[position], old_record));
+
+        free_records_arr(*data, *size);
+        *data = current_data;
+        *size = current_data != NULL ? current_size : 0;
+        capacity = *size;
+
+        if (!*is_saved) {
+            unlock_working_log();
+            return working_file;
+        }
+    }
+
+    wal_entry entry = make_wal_entry(operation, position, *size, old_record, new_record);
+    bool is_logged = log_record_change(&entry) && commit_working_log();
+
+    unlock_working_log();
+
+    apply_wal_entry(data, size, &capacity, &entry);
+    *is_saved = true;
+
+    if (is_logged) {
+        return working_file;
+    }
+
+    return checkpoint_working_file(working_file, working_file_name, *data, *size);
+}
+
+FILE *save_record_move(FILE *working_file, char *working_file_name, record ***data, int *size,
+                       int old_position, int *new_position, const sort_keys *keys,
+                       const record *old_record, const record *new_record, bool *is_saved) {
+    int current_size = 0;
+
+    lock_working_log(LOCK_EX);
+
+    if (refresh_working_log(working_file)) {
+        record **current_data = get_records_arr(working_file, &current_size);
+
+        *is_saved = current_data != NULL && current_size == *size &&
+                    is_same_record(current_data[old_position], old_record);
+
+        free_records_arr(*data, *size);
+        *data = current_data;
+        *size = current_data != NULL ? current_size : 0;
+
+        if (!*is_saved) {
+            unlock_working_log();
+            return working_file;
+        }
+
+        *new_position = find_move_position(*data, *size, old_position, new_record, keys);
+    }
+
+    wal_entry entries[2] = {make_wal_entry(WAL_DELETE, old_position, *size, old_record, NULL),
+                            make_wal_entry(WAL_INSERT, *new_position, *size - 1, NULL, new_record)};
+    bool is_logged = log_record_changes(entries, 2) && commit_working_log();
+
+    unlock_working_log();
+
+    move_record(*data, old_position, *new_position, new_record);
+    *is_saved = true;
+
+    if (is_logged) {
+        return working_file;
+    }
+
+    return checkpoint_working_file(working_file, working_file_name, *data, *size);
+}
+
+void move_record(record **data, int old_position, int new_position, const record *new_record) {
+    record *moved = data[old_position];
+
+    *moved = *new_record;
+
+    if (new_position > old_position) {
+        memmove(data + old_position, data + old_position + 1, (new_position - old_position) * sizeof(record *));
+    } else {
+        memmove(data + new_position + 1, data + new_position, (old_position - new_position) * sizeof(record *));
+    }
+
+    data[new_position] = moved;
+}
+
+int find_move_position(record **data, int size, int old_position, const record *new_record, const sort_keys *keys) {
+    if ((old_position == 0 || compare_records_by_keys(data[old_position - 1], new_record, keys) <= 0) &&
+        (old_position == size - 1 || compare_records_by_keys(new_record, data[old_position + 1], keys) <= 0)) {
+        return old_position;
+    }
+
+    int low = 0, high = size - 1;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        const record *current = data[middle < old_position ? middle : middle + 1];
+
+        if (compare_records_by_keys(current, new_record, keys) > 0) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    return low;
+}
+
+FILE *open_working_log(FILE *working_file, char *working_file_name) {
+    struct stat data_stat;
+    uint32_t checksum = 0;
+    bool is_valid = false, is_import_pending = false, is_stamped = false;
+    int recovered = 0;
+    wal_entry entry;
+
+    char log_filepath[PATH_SIZE + NAME_MAX];
+    get_sidecar_filepath(log_filepath, sizeof(log_filepath), working_file_name, "wal");
+    snprintf(working_log->data_path, sizeof(working_log->data_path), "%s/%s", working_folder, working_file_name);
+
+    working_log->fd = open(log_filepath, O_RDWR | O_CREAT, 0666);
+    working_log->data_file = working_file;
+    working_log->size = 0;
+    working_log->unsynced = 0;
+    working_log->lock_depth = 0;
+
+    if (working_log->fd == -1) {
+        printf("Error:" ITALIC_TEXT " Can't open the write-ahead log, changes will not be logged\n"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        return working_file;
+    }
+
+    lock_working_log(LOCK_EX);
+    remove_temp_files(working_file_name);
+
+    if (fstat(fileno(working_file), &data_stat) == 0 &&
+        pread(working_log->fd, &working_log->header, sizeof(wal_header), 0) == sizeof(wal_header) &&
+        memcmp(working_log->header.magic, WAL_MAGIC, WAL_MAGIC_SIZE) == 0 &&
+        working_log->header.base_length <= (uint64_t) data_stat.st_size &&
+        ((is_stamped = is_line_index_stamped(working_file_name, &working_log->header, &data_stat)) ||
+         (get_file_checksum(fileno(working_file), working_log->header.base_length, &checksum) &&
+          checksum == working_log->header.base_checksum))) {
+
+        off_t offset = sizeof(wal_header);
+        is_valid = true;
+
+        while (pread(working_log->fd, &entry, sizeof(wal_entry), offset) == sizeof(wal_entry) &&
+               is_valid_wal_entry(&entry) && add_wal_entry(&entry)) {
+            if (entry.operation == WAL_IMPORT) {
+                is_import_pending = true;
+            } else {
+                recovered++;
+            }
+            offset += sizeof(wal_entry);
+        }
+
+        ftruncate(working_log->fd, offset);
+
+        if (working_log->header.base_length < (uint64_t) data_stat.st_size && !is_import_pending) {
+            is_valid = false;
+        }
+    }
+
+    if (!is_valid) {
+        fstat(fileno(working_file), &data_stat);
+        get_file_checksum(fileno(working_file), data_stat.st_size, &checksum);
+        reset_working_log(checksum, data_stat.st_size);
+        unlock_working_log();
+        return working_file;
+    }
+
+    if (!is_stamped && !is_import_pending) {
+        stamp_line_index(working_file_name, &working_log->header, &data_stat);
+    }
+
+    if (is_import_pending) {
+        ftruncate(fileno(working_file), (off_t) working_log->header.base_length);
+        printf("Unfinished import into %s was rolled back\n", working_file_name);
+    }
+
+    if (recovered > 0) {
+        printf("Recovered %i changes from the write-ahead log\n", recovered);
+    }
+
+    working_file = flush_working_log(working_file, working_file_name, 1);
+
+    unlock_working_log();
+
+    return working_file;
+}
+
+void close_working_file(FILE *working_file, char *working_file_name) {
+    if (working_file == NULL || file_exists(working_log->data_path)) {
+        working_file = flush_working_log(working_file, working_file_name, 1);
+        commit_working_log();
+    }
+
+    release_working_file(working_file);
+}
+
+void release_working_file(FILE *working_file) {
+    if (working_log->fd != -1) {
+        close(working_log->fd);
+        working_log->fd = -1;
+    }
+
+    free(working_log->entries);
+    working_log->entries = NULL;
+    working_log->capacity = 0;
+    working_log->data_file = NULL;
+    working_log->size = 0;
+    working_log->lock_depth = 0;
+
+    if (working_file != NULL) {
+        fclose(working_file);
+    }
+}
+
+FILE *open_file(FILE *opened_file, char **file_name) {
+    bool is_exit = false;
+    char chosen_name[NAME_MAX + 1];
+    FILE *file = NULL;
+
+    if (browse_catalog("Open file", chosen_name, &is_exit) == 0) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " Empty folder"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return NULL;
+    }
+
+    if (is_exit) {
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return NULL;
+    }
+
+    if (opened_file != NULL) {
+        close_working_file(opened_file, *file_name);
+    }
+
+    char filepath[PATH_SIZE + NAME_MAX];
+    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, chosen_name);
 
     if (file_exists(filepath)) {
-        printf("\nFile wasn't created: "ITALIC_TEXT"%s.txt already exists"
+
+        file = fopen(filepath, "a+");
+
+        if (file == NULL) {
+            printf("\nError:" ITALIC_TEXT " Can't open the file for writing"
+                   RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+            return NULL;
+        }
+
+    }
+
+    *file_name = strdup(chosen_name);
+
+    if (file != NULL) {
+        file = open_working_log(file, *file_name);
+    }
+
+    printf("File %s opened successfully!\n", chosen_name);
+
+    return file;
+}
+
+FILE *delete_file(FILE *working_file, char *working_file_name) {
+    bool is_exit = false;
+    char deleted_file_name[NAME_MAX + 1];
+
+    if (browse_catalog("Delete file", deleted_file_name, &is_exit) == 0) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " Empty folder"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    if (is_exit) {
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    char filepath[PATH_SIZE + NAME_MAX];
+    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, deleted_file_name);
+
+    if (file_exists(filepath)) {
+        if (working_file != NULL && strcmp(deleted_file_name, working_file_name) == 0) {
+            release_working_file(working_file);
+            working_file = NULL;
+        }
+
+        if (!remove(filepath)) {
+            char sidecar_filepath[PATH_SIZE + NAME_MAX];
+            get_sidecar_filepath(sidecar_filepath, sizeof(sidecar_filepath), deleted_file_name, "wal");
+            remove(sidecar_filepath);
+            remove_record_views(deleted_file_name);
+            get_sidecar_filepath(sidecar_filepath, sizeof(sidecar_filepath), deleted_file_name, "sorted");
+            remove(sidecar_filepath);
+            get_sidecar_filepath(sidecar_filepath, sizeof(sidecar_filepath), deleted_file_name, "idx");
+            remove(sidecar_filepath);
+            remove_temp_files(deleted_file_name);
+
+            system("clear");
+            refresh_catalog();
+            show_files(NOT_INTERACTIVE, CATALOG_PAGE_DEFAULT);
+
+            printf("\nFile "GREEN_BG BLACK_TEXT"%s"BLACK_BG GREEN_TEXT
+                   " has been deleted successfully", deleted_file_name);
+            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+                   "close the program or any other button to return to the menu");
+            return working_file;
+        } else {
+            printf("\nError:" ITALIC_TEXT " Can't delete the file"
+                   RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        }
+    } else {
+        printf("\nError:" ITALIC_TEXT " File was not found"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    return working_file;
+}
+
+void create_record(FILE *working_file, char *working_file_name) {
+    int size = 0, pending = 0, added = 0;
+    bool is_saved = true;
+    record input_data;
+    wal_entry entries[APPEND_BATCH_SIZE];
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return;
+    }
+
+    record **data = get_records_arr(working_file, &size);
+    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+    free_records_arr(data, size);
+
+    do {
+        do {
+            printf("\nEnter name of region (max %i characters): ", REGION_NAME_MAX - 1);
+        } while (!string_input(input_data.region_name, REGION_NAME_MAX));
+
+        do {
+            printf("\nEnter size of region area [%.0lf; %.0lf]: ", area_min, area_max);
+        } while (!input_double(&input_data.region_area) ||
+                 !is_correct_area(&input_data.region_area, area_min, area_max));
+
+        do {
+            printf("\nEnter population of region [%i; %i]: ", population_min, population_max);
+        } while (!input_int(&input_data.region_population) ||
+                 !is_correct_population(&input_data.region_population, population_min, population_max));
+
+        entries[pending++] = make_wal_entry(WAL_APPEND, size, size, NULL, &input_data);
+        size++;
+        added++;
+
+        if (pending == APPEND_BATCH_SIZE) {
+            is_saved = append_records(working_file, entries, pending) && is_saved;
+            pending = 0;
+        }
+
+        printf("\n");
+        show_record_row(NOT_INTERACTIVE, size - 1, &input_data);
+        printf("\nRecord was added successfully!");
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to stop input "
+               "\nor any other button to continue input records\n");
+
+    } while (key_pressed() != EXIT_BUTTON);
+
+    if (pending > 0) {
+        is_saved = append_records(working_file, entries, pending) && is_saved;
+    }
+
+    if (is_saved) {
+        printf("\n%i records were saved to file %s, it has %i records now", added, working_file_name, size);
+    } else {
+        printf("\nError:" ITALIC_TEXT " Can't save the records to file %s"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, working_file_name);
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+}
+
+bool append_records(FILE *working_file, const wal_entry *entries, int count) {
+    write_buffer buffer;
+    bool is_written = true;
+
+    if (log_record_changes(entries, count)) {
+        return commit_working_log();
+    }
+
+    if (!init_write_buffer(&buffer, working_file, WRITE_BUFFER_SIZE)) {
+        return false;
+    }
+
+    for (int i = 0; i < count && is_written; i++) {
+        is_written = buffer_write_record(&buffer, &entries[i].new_record);
+    }
+
+    is_written = flush_write_buffer(&buffer) && is_written;
+    free_write_buffer(&buffer);
+
+    return is_written;
+}
+
+void show_records(int current_position, char *working_file_name, int size, record **data) {
+
+    system("clear");
+
+    if (size == 0) {
+        printf("File %s is empty\n", working_file_name);
+        return;
+    }
+
+    uint64_t start = start_timer(), span = begin_span();
+
+    printf("Records in file %s\n\n", working_file_name);
+    printf("%-5s%-30s%-20s%-20s\n", "No.", "REGION NAME", "AREA SIZE", "POPULATION");
+    for (int i = 0; i < size; i++) {
+        show_record_row(current_position, i, data[i]);
+    }
+
+    stop_timer(RENDER_TIMER, start);
+    end_span("show_records", span);
+}
+
+void show_record_row(int current_position, int index, const record *data) {
+    printf("%s%-5d%-30s%-20.2lf%-20i%s\n",
+           (current_position == index) ? GREEN_BG BLACK_TEXT : "",
+           index + 1,
+           data->region_name,
+           data->region_area,
+           data->region_population,
+           (current_position == index) ? BLACK_BG GREEN_TEXT : "");
+}
+
+FILE *read_record(FILE *working_file, char *working_file_name) {
+    int size = 0, first = 0, records = 0, lines = get_terminal_lines();
+    int page_size = lines > RECORDS_PAGE_MIN + 8 ? lines - 8 : RECORDS_PAGE_DEFAULT;
+    bool is_exit = false, is_indexed = false;
+    line_index index;
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    record *page = (record *) malloc(page_size * sizeof(record));
+
+    init_line_index(&index);
+
+    while (page != NULL && !is_exit) {
+        lock_working_log(LOCK_SH);
+        refresh_working_log(working_file);
+
+        is_indexed = get_line_index(working_file, working_file_name, &index);
+        records = is_indexed ? get_current_records(&index) : 0;
+
+        if (first >= records) {
+            first = records > 0 ? (records - 1) / page_size * page_size : 0;
+        }
+
+        size = is_indexed ? read_current_records(fileno(working_file), &index, first, page_size, page) : -1;
+
+        unlock_working_log();
+
+        if (size == -1) {
+            break;
+        }
+
+        show_records_page(working_file_name, first, size, records, page);
+        printf("\nUse "GREEN_BG BLACK_TEXT"AD"BLACK_BG GREEN_TEXT" to change the page, "
+               GREEN_BG BLACK_TEXT"G"BLACK_BG GREEN_TEXT" to go to a record. Press "
+               GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to exit\n");
+
+        switch (toupper(key_pressed())) {
+            case 'W':
+            case 'A':
+                first = first >= page_size ? first - page_size : 0;
+                break;
+            case 'S':
+            case 'D':
+                first += first + page_size < records ? page_size : 0;
+                break;
+            case 'G':
+                if (records > 0) {
+                    do {
+                        printf("\nEnter number of record [1; %i]: ", records);
+                    } while (!input_int(&first) || first < 1 || first > records);
+
+                    first--;
+                }
+                break;
+            case EXIT_BUTTON:
+                is_exit = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    free(page);
+    free_line_index(&index);
+
+    if (!is_exit) {
+        record **data = get_records_arr(working_file, &size);
+
+        show_records(NOT_INTERACTIVE, working_file_name, size, data);
+
+        free_records_arr(data, size);
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    return working_file;
+}
+
+void show_records_page(char *working_file_name, int first, int size, int records, const record *page) {
+
+    system("clear");
+
+    if (records == 0) {
+        printf("File %s is empty\n", working_file_name);
+        return;
+    }
+
+    uint64_t start = start_timer(), span = begin_span();
+
+    printf("Records %i-%i of %i in file %s\n\n", first + 1, first + size, records, working_file_name);
+    printf("%-5s%-30s%-20s%-20s\n", "No.", "REGION NAME", "AREA SIZE", "POPULATION");
+
+    for (int i = 0; i < size; i++) {
+        show_record_row(NOT_INTERACTIVE, first + i, &page[i]);
+    }
+
+    stop_timer(RENDER_TIMER, start);
+    end_span("show_records_page", span);
+}
+
+FILE *delete_record(FILE *working_file, char *working_file_name) {
+    int size = 0, current_position = 0;
+    bool is_chosen = false, is_exit = false;
+
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    record **data = get_records_arr(working_file, &size);
+
+    if (size == 0) {
+        system("clear");
+
+        printf("Error:" ITALIC_TEXT " Empty file"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    do {
+        system("clear");
+        show_records(current_position, working_file_name, size, data);
+        current_position = navigate_list(current_position, size, &is_exit, &is_chosen);
+
+        if (is_exit) {
+            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+                   "close the program or any other button to return to the menu");
+            return working_file;
+        }
+    } while (!is_chosen);
+
+    if (is_exit) {
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    record temp_data = *data[current_position];
+    bool is_saved;
+
+    working_file = save_record_change(working_file, working_file_name, &data, &size,
+                                      WAL_DELETE, current_position, &temp_data, NULL, &is_saved);
+
+    system("clear");
+
+    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+
+    if (is_saved) {
+        printf("\nRecord №%i [%s %lf %i] was deleted successfully!",
+               current_position + 1, temp_data.region_name,
+               temp_data.region_area, temp_data.region_population);
+    } else {
+        printf("\nError:" ITALIC_TEXT " File was changed by another process, record was not deleted"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+    }
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    free_records_arr(data, size);
+
+    return working_file;
+}
+
+FILE *edit_record(FILE *working_file, char *working_file_name) {
+    int size = 0, current_position = 0;
+    bool is_chosen = false, is_exit = false;
+    line_index index;
+
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    init_line_index(&index);
+    lock_working_log(LOCK_SH);
+    refresh_working_log(working_file);
+
+    bool is_indexed = get_line_index(working_file, working_file_name, &index);
+
+    size = is_indexed ? get_current_records(&index) : 0;
+
+    unlock_working_log();
+
+    if (size > EDIT_LIST_MAX) {
+        working_file = edit_indexed_record(working_file, working_file_name, &index);
+        free_line_index(&index);
+        return working_file;
+    }
+
+    free_line_index(&index);
+
+    record **data = get_records_arr(working_file, &size);
+
+    if (size == 0) {
+        system("clear");
+
+        printf("Error:" ITALIC_TEXT " Empty file"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    do {
+        system("clear");
+        show_records(current_position, working_file_name, size, data);
+        current_position = navigate_list(current_position, size, &is_exit, &is_chosen);
+
+        if (is_exit) {
+            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+                   "close the program or any other button to return to the menu");
+            return working_file;
+        }
+    } while (!is_chosen);
+
+    if (is_exit) {
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    record input_data;
+    record temp_data = *data[current_position];
+
+    do {
+        printf("Enter name of region (max %i characters): ", REGION_NAME_MAX - 1);
+    } while (!string_input(input_data.region_name, REGION_NAME_MAX));
+
+    do {
+        printf("\nEnter size of region area [%.0lf; %.0lf]: ", area_min, area_max);
+    } while (!input_double(&input_data.region_area) ||
+             !is_correct_area(&input_data.region_area, area_min, area_max));
+
+    do {
+        printf("\nEnter population of region [%i; %i]: ", population_min, population_max);
+    } while (!input_int(&input_data.region_population) ||
+             !is_correct_population(&input_data.region_population,
+                                    population_min, population_max));
+
+    bool is_saved, is_sorted;
+    sort_keys keys;
+    char keys_text[256];
+    int new_position = current_position, prefix = 0;
+
+    lock_working_log(LOCK_EX);
+
+    is_sorted = size > 1 && load_sorted_prefix(working_file_name, &working_log->header, working_log->entries,
+                                               working_log->size, &keys, &prefix) && prefix >= size;
+
+    if (is_sorted) {
+        new_position = find_move_position(data, size, current_position, &input_data, &keys);
+    }
+
+    if (new_position == current_position) {
+        working_file = save_record_change(working_file, working_file_name, &data, &size,
+                                          WAL_EDIT, current_position, &temp_data, &input_data, &is_saved);
+    } else {
+        working_file = save_record_move(working_file, working_file_name, &data, &size,
+                                        current_position, &new_position, &keys, &temp_data, &input_data,
+                                        &is_saved);
+    }
+
+    if (is_saved && is_sorted && is_sorted_by_keys(data, size, &keys)) {
+        save_sorted_prefix(working_file_name, &working_log->header, &keys, size);
+    }
+
+    unlock_working_log();
+
+    system("clear");
+
+    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+
+    if (is_saved) {
+        printf("\nRecord №%i " ITALIC_TEXT "[%s %lf %i]"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT
+               " was replaced with record " ITALIC_TEXT "[%s %lf %i]"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT,
+               current_position + 1, temp_data.region_name,
+               temp_data.region_area, temp_data.region_population,
+               input_data.region_name, input_data.region_area, input_data.region_population);
+
+        if (new_position != current_position) {
+            format_sort_keys(keys_text, sizeof(keys_text), &keys);
+            printf("\nand moved to №%i to keep the file sorted by %s", new_position + 1, keys_text);
+        }
+    } else {
+        printf("\nError:" ITALIC_TEXT " File was changed by another process, record was not edited"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+    }
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    free_records_arr(data, size);
+
+    return working_file;
+}
+
+FILE *edit_indexed_record(FILE *working_file, char *working_file_name, line_index *index) {
+    int size = get_current_records(index), current_position = 0, new_position, prefix = 0, count = 1;
+    bool is_saved = false, is_logged = false, is_committed = false, is_sorted;
+    record input_data, temp_data, current_data;
+    wal_entry entries[2];
+    sort_keys keys;
+    char keys_text[256];
+
+    system("clear");
+    printf("File %s has %i records\n", working_file_name, size);
+
+    do {
+        printf("\nEnter number of record to edit [1; %i]: ", size);
+    } while (!input_int(&current_position) || current_position < 1 || current_position > size);
+
+    current_position--;
+
+    lock_working_log(LOCK_SH);
+    is_saved = read_current_records(fileno(working_file), index, current_position, 1, &temp_data) == 1;
+    unlock_working_log();
+
+    if (!is_saved) {
+        printf("\nError:" ITALIC_TEXT " Can't read the record"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    printf("\n%-5s%-30s%-20s%-20s\n", "No.", "REGION NAME", "AREA SIZE", "POPULATION");
+    show_record_row(NOT_INTERACTIVE, current_position, &temp_data);
+    printf("\n");
+
+    do {
+        printf("Enter name of region (max %i characters): ", REGION_NAME_MAX - 1);
+    } while (!string_input(input_data.region_name, REGION_NAME_MAX));
+
+    do {
+        printf("\nEnter size of region area [%.0lf; %.0lf]: ", area_min, area_max);
+    } while (!input_double(&input_data.region_area) ||
+             !is_correct_area(&input_data.region_area, area_min, area_max));
+
+    do {
+        printf("\nEnter population of region [%i; %i]: ", population_min, population_max);
+    } while (!input_int(&input_data.region_population) ||
+             !is_correct_population(&input_data.region_population,
+                                    population_min, population_max));
+
+    lock_working_log(LOCK_EX);
+    refresh_working_log(working_file);
+
+    is_saved = get_line_index(working_file, working_file_name, index) && get_current_records(index) == size &&
+               read_current_records(fileno(working_file), index, current_position, 1, &current_data) == 1 &&
+               is_same_record(&current_data, &temp_data);
+    new_position = current_position;
+
+    is_sorted = is_saved && size > 1 &&
+                load_sorted_prefix(working_file_name, &working_log->header, working_log->entries,
+                                   working_log->size, &keys, &prefix) && prefix >= size;
+
+    if (is_sorted) {
+        new_position = find_indexed_move_position(fileno(working_file), index, size, current_position,
+                                                  &input_data, &keys);
+    }
+
+    if (new_position == current_position) {
+        entries[0] = make_wal_entry(WAL_EDIT, current_position, size, &temp_data, &input_data);
+    } else {
+        entries[0] = make_wal_entry(WAL_DELETE, current_position, size, &temp_data, NULL);
+        entries[1] = make_wal_entry(WAL_INSERT, new_position, size - 1, NULL, &input_data);
+        count = 2;
+    }
+
+    is_logged = is_saved && log_record_changes(entries, count);
+    is_committed = is_logged && commit_working_log();
+
+    if (is_saved && !is_committed) {
+        int capacity = 0;
+        record **data = get_records_arr(working_file, &capacity);
+
+        size = capacity;
+
+        for (int i = 0; i < count && data != NULL && !is_logged; i++) {
+            apply_wal_entry(&data, &size, &capacity, &entries[i]);
+        }
+
+        if (data != NULL) {
+            working_file = checkpoint_working_file(working_file, working_file_name, data, size);
+        }
+
+        free_records_arr(data, data != NULL ? size : 0);
+    }
+
+    if (is_sorted) {
+        save_sorted_prefix(working_file_name, &working_log->header, &keys, size);
+    }
+
+    unlock_working_log();
+
+    if (is_saved) {
+        printf("\nRecord №%i " ITALIC_TEXT "[%s %lf %i]"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT
+               " was replaced with record " ITALIC_TEXT "[%s %lf %i]"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT,
+               current_position + 1, temp_data.region_name,
+               temp_data.region_area, temp_data.region_population,
+               input_data.region_name, input_data.region_area, input_data.region_population);
+
+        if (new_position != current_position) {
+            format_sort_keys(keys_text, sizeof(keys_text), &keys);
+            printf("\nand moved to №%i to keep the file sorted by %s", new_position + 1, keys_text);
+        }
+    } else {
+        printf("\nError:" ITALIC_TEXT " File was changed by another process, record was not edited"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    return working_file;
+}
+
+void show_sort_options(enum sort_option current_option) {
+
+    printf("\nChoose how to sort\n");
+
+    for (int i = 0; i < NUMBER_OF_SORTS; i++) {
+        printf("%s by %s%s\n",
+               (current_option == i) ? GREEN_BG BLACK_TEXT "-->" : "",
+               sort_option_names[i],
+               (current_option == i) ? BLACK_BG GREEN_TEXT : "");
+    }
+}
+
+void show_order_options(enum order_option current_option) {
+
+    printf("\nChoose in which order to sort\n");
+
+    for (int i = 0; i < NUMBER_OF_ORDERS; i++) {
+        printf("%s in %s%s\n",
+               (current_option == i) ? GREEN_BG BLACK_TEXT "-->" : "",
+               order_option_names[i],
+               (current_option == i) ? BLACK_BG GREEN_TEXT : "");
+    }
+}
+
+void swap_records(record **record1, record **record2) {
+    record *temp = *record1;
+    *record1 = *record2;
+    *record2 = temp;
+}
+
+void sort_records(record **data, int size,
+                  enum sort_option sort_option,
+                  enum order_option order_option) {
+    sort_keys keys = {1, {sort_option}, {order_option}};
+
+    sort_records_by_keys(data, size, &keys);
+}
+
+void sort_records_by_keys(record **data, int size, const sort_keys *keys) {
+    uint64_t start = start_timer(), span = begin_span();
+    uint32_t *permutation = size < 2 ? NULL : (uint32_t *) malloc(size * sizeof(uint32_t));
+    record **sorted = size < 2 ? NULL : (record **) malloc(size * sizeof(record *));
+
+    if (permutation != NULL && sorted != NULL && sort_record_permutation(data, size, keys, permutation)) {
+        for (int i = 0; i < size; i++) {
+            sorted[i] = data[permutation[i]];
+        }
+
+        memcpy(data, sorted, size * sizeof(record *));
+    } else {
+        for (int i = 0; i < size - 1; i++) {
+            for (int j = 0; j < size - i - 1; j++) {
+                if (compare_records_by_keys(data[j], data[j + 1], keys) > 0) {
+                    swap_records(&data[j], &data[j + 1]);
+                }
+            }
+        }
+    }
+
+    free(permutation);
+    free(sorted);
+
+    stop_timer(SORT_TIMER, start);
+    end_span("sort_records", span);
+}
+
+bool sort_record_permutation(record **data, int size, const sort_keys *keys, uint32_t *permutation) {
+    bool is_name_key = false, is_keyed;
+    int key_size = 0;
+    name_pool pool = {0};
+
+    for (int i = 0; i < keys->size; i++) {
+        is_name_key = is_name_key || keys->sorts[i] == NAME_SORT;
+    }
+
+    unsigned char *packed_keys = (unsigned char *) malloc((size_t) size * SORT_KEY_SIZE_MAX + 1);
+    keyed_record *items = (keyed_record *) malloc(2 * (size_t) size * sizeof(keyed_record) + 1);
+
+    is_keyed = packed_keys != NULL && items != NULL && (!is_name_key || init_name_pool(&pool, size));
+
+    for (int i = 0; i < size && is_name_key && is_keyed; i++) {
+        is_keyed = intern_name(&pool, data[i]->region_name) != -1;
+    }
+
+    is_keyed = is_keyed && (!is_name_key || rank_name_pool(&pool));
+
+    for (int i = 0; i < size && is_keyed; i++) {
+        uint32_t name_rank = is_name_key ? pool.ranks[intern_name(&pool, data[i]->region_name)] : 0;
+
+        key_size = pack_sort_key(packed_keys + (size_t) i * SORT_KEY_SIZE_MAX, data[i], name_rank, keys);
+        items[i].key = packed_keys + (size_t) i * SORT_KEY_SIZE_MAX;
+        items[i].index = i;
+    }
+
+    if (is_keyed) {
+        merge_sort_keyed(items, items + size, size, key_size);
+
+        for (int i = 0; i < size; i++) {
+            permutation[i] = (uint32_t) items[i].index;
+        }
+    }
+
+    free_name_pool(&pool);
+    free(packed_keys);
+    free(items);
+
+    return is_keyed;
+}
+
+int pack_sort_key(unsigned char *key, const record *data, uint32_t name_rank, const sort_keys *keys) {
+    int key_size = 0;
+
+    for (int i = 0; i < keys->size; i++) {
+        uint64_t value;
+        int size;
+
+        switch (keys->sorts[i]) {
+            case NAME_SORT:
+                value = name_rank;
+                size = sizeof(uint32_t);
+                break;
+            case AREA_SORT: {
+                double area = data->region_area == 0 ? 0 : data->region_area;
+
+                memcpy(&value, &area, sizeof(value));
+                value = value >> 63 ? ~value : value | 1ULL << 63;
+                size = sizeof(uint64_t);
+                break;
+            }
+            default:
+                value = (uint32_t) data->region_population ^ 0x80000000U;
+                size = sizeof(uint32_t);
+        }
+
+        if (keys->orders[i] == DESCENDING_ORDER) {
+            value = ~value;
+        }
+
+        for (int byte = size - 1; byte >= 0; byte--) {
+            key[key_size++] = (unsigned char) (value >> (byte * 8));
+        }
+    }
+
+    return key_size;
+}
+
+void merge_sort_keyed(keyed_record *items, keyed_record *temp, int size, int key_size) {
+    keyed_record *source = items, *target = temp;
+
+    for (int run = 0; run < size; run += SORT_RUN_SIZE) {
+        int end = run + SORT_RUN_SIZE < size ? run + SORT_RUN_SIZE : size;
+
+        for (int i = run + 1; i < end; i++) {
+            keyed_record item = items[i];
+            int j = i;
+
+            while (j > run && memcmp(items[j - 1].key, item.key, key_size) > 0) {
+                items[j] = items[j - 1];
+                j--;
+            }
+
+            items[j] = item;
+        }
+    }
+
+    for (long width = SORT_RUN_SIZE; width < size; width *= 2) {
+        for (long left = 0; left < size; left += 2 * width) {
+            long middle = left + width < size ? left + width : size;
+            long right = left + 2 * width < size ? left + 2 * width : size;
+            long i = left, j = middle, k = left;
+
+            while (i < middle && j < right) {
+                target[k++] = memcmp(source[j].key, source[i].key, key_size) < 0 ? source[j++] : source[i++];
+            }
+
+            while (i < middle) {
+                target[k++] = source[i++];
+            }
+
+            while (j < right) {
+                target[k++] = source[j++];
+            }
+        }
+
+        keyed_record *swap = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != items) {
+        memcpy(items, source, size * sizeof(keyed_record));
+    }
+}
+
+void format_sort_keys(char *text, size_t size, const sort_keys *keys) {
+    int length = 0;
+
+    text[0] = '\0';
+
+    for (int i = 0; i < keys->size && length >= 0 && (size_t) length < size; i++) {
+        length += snprintf(text + length, size - length, "%s%s in %s", i > 0 ? ", then by " : "",
+                           sort_option_names[keys->sorts[i]], order_option_names[keys->orders[i]]);
+    }
+}
+
+bool add_sort_key(sort_keys *keys, enum sort_option sort_option, enum order_option order_option) {
+    for (int i = 0; i < keys->size; i++) {
+        if (keys->sorts[i] == sort_option) {
+            return false;
+        }
+    }
+
+    keys->sorts[keys->size] = sort_option;
+    keys->orders[keys->size] = order_option;
+    keys->size++;
+
+    return true;
+}
+
+bool is_sorted_by_keys(record **data, int size, const sort_keys *keys) {
+    for (int i = 1; i < size; ++i) {
+        if (compare_records_by_keys(data[i - 1], data[i], keys) > 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool breaks_sort_ties(record **data, int size, const sort_keys *keys) {
+    sort_keys prefix = *keys;
+    enum sort_option sort_option = keys->sorts[keys->size - 1];
+    enum order_option order_option = keys->orders[keys->size - 1];
+    bool is_broken = false;
+
+    prefix.size--;
+
+    for (int i = 1; i < size; ++i) {
+        if (compare_records_by_keys(data[i - 1], data[i], &prefix) == 0) {
+            int comparison_result = compare_records(data[i - 1], data[i], sort_option, order_option);
+
+            if (comparison_result > 0) {
+                return false;
+            }
+
+            is_broken = is_broken || comparison_result < 0;
+        }
+    }
+
+    return is_broken;
+}
+
+bool check_sort_order(record **data, int size, sort_keys *found_keys) {
+    bool is_extended = true;
+
+    found_keys->size = 0;
+
+    while (is_extended && found_keys->size < NUMBER_OF_SORTS) {
+        is_extended = false;
+
+        for (int sort = 0; sort < NUMBER_OF_SORTS && !is_extended; ++sort) {
+            for (int order = 0; order < NUMBER_OF_ORDERS && !is_extended; ++order) {
+                if (add_sort_key(found_keys, sort, order)) {
+                    is_extended = breaks_sort_ties(data, size, found_keys);
+                    found_keys->size -= !is_extended;
+                }
+            }
+        }
+    }
+
+    if (found_keys->size == 0) {
+        add_sort_key(found_keys, NAME_SORT, DESCENDING_ORDER);
+        return is_sorted_by_keys(data, size, found_keys);
+    }
+
+    return true;
+}
+
+FILE *order_records(FILE *working_file, char *working_file_name) {
+    int size = 0;
+    bool is_chosen_sort = false, is_chosen_order = false, is_exit = false, is_more_keys = false;
+    enum sort_option current_sort_option = NAME_SORT;
+    enum order_option current_order_option = DESCENDING_ORDER;
+    sort_keys keys = {0};
+    char keys_text[256];
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        return working_file;
+    }
+
+    record **data = get_records_arr(working_file, &size);
+
+    if (size == 0) {
+        system("clear");
+
+        printf("Error:" ITALIC_TEXT " Empty file"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    do {
+        system("clear");
+
+        show_records(NOT_INTERACTIVE, working_file_name, size, data);
+
+        if (keys.size > 0) {
+            format_sort_keys(keys_text, sizeof(keys_text), &keys);
+            printf("\nSorting by %s, then by\n", keys_text);
+        }
+
+        if (!is_chosen_sort) {
+            show_sort_options(current_sort_option);
+            current_sort_option = navigate_list(current_sort_option, NUMBER_OF_SORTS,
+                                                &is_exit, &is_chosen_sort);
+        }
+
+        if (is_exit) {
+            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+                   "close the program or any other button to return to the menu");
+            return working_file;
+        }
+
+        if (is_chosen_sort) {
+            system("clear");
+
+            show_records(NOT_INTERACTIVE, working_file_name, size, data);
+
+            if (keys.size > 0) {
+                printf("\nSorting by %s, then by\n", keys_text);
+            }
+
+            show_sort_options(current_sort_option);
+            show_order_options(current_order_option);
+            current_order_option = navigate_list(current_order_option, NUMBER_OF_ORDERS,
+                                                 &is_exit, &is_chosen_order);
+        }
+
+        if (is_exit) {
+            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+                   "close the program or any other button to return to the menu");
+            return working_file;
+        }
+
+        if (is_chosen_sort && is_chosen_order) {
+            add_sort_key(&keys, current_sort_option, current_order_option);
+            is_more_keys = false;
+
+            if (keys.size < NUMBER_OF_SORTS) {
+                printf("\n\nPress "GREEN_BG BLACK_TEXT"T"BLACK_BG GREEN_TEXT" to add a tie-breaking key "
+                       "or any other button to sort\n");
+                is_more_keys = toupper(key_pressed()) == 'T';
+            }
+
+            is_chosen_sort = !is_more_keys;
+            is_chosen_order = !is_more_keys;
+            current_sort_option = NAME_SORT;
+            current_order_option = DESCENDING_ORDER;
+        }
+
+    } while (!is_chosen_sort || !is_chosen_order);
+
+    lock_working_log(LOCK_EX);
+
+    if (refresh_working_log(working_file)) {
+        free_records_arr(data, size);
+        data = get_records_arr(working_file, &size);
+    }
+
+    int unsorted = resort_records(working_file_name, data, size, &keys);
+    uint64_t checkpoints = working_log->checkpoints;
+
+    system("clear");
+
+    format_sort_keys(keys_text, sizeof(keys_text), &keys);
+    printf("File was sorted by %s successfully!\n", keys_text);
+
+    if (unsorted < size) {
+        printf("Only the last %i records were sorted and merged into the sorted part\n", unsorted);
+    }
+
+    printf("Your updated file:\n");
+
+    working_file = checkpoint_working_file(working_file, working_file_name, data, size);
+
+    if (working_log->checkpoints != checkpoints) {
+        save_sorted_prefix(working_file_name, &working_log->header, &keys, size);
+    }
+
+    unlock_working_log();
+
+    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+
+    free_records_arr(data, size);
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    return working_file;
+}
+
+int compare_top_records(const top_record *first, const top_record *second, const sort_keys *keys) {
+    int result = compare_records_by_keys(&first->data, &second->data, keys);
+
+    return result != 0 ? result : (first->position > second->position) - (first->position < second->position);
+}
+
+void sift_down_top_heap(top_record *heap, int size, int position, const sort_keys *keys) {
+    while (true) {
+        int left = 2 * position + 1, right = left + 1, largest = position;
+
+        if (left < size && compare_top_records(&heap[left], &heap[largest], keys) > 0) {
+            largest = left;
+        }
+
+        if (right < size && compare_top_records(&heap[right], &heap[largest], keys) > 0) {
+            largest = right;
+        }
+
+        if (largest == position) {
+            return;
+        }
+
+        top_record swap = heap[position];
+        heap[position] = heap[largest];
+        heap[largest] = swap;
+        position = largest;
+    }
+}
+
+int find_top_records(overlay_reader *reader, const sort_keys *keys, int k, top_record *top) {
+    top_record candidate = {.position = 0};
+    int size = 0;
+
+    while (read_overlay_record(reader, &candidate.data)) {
+        if (size < k) {
+            int position = size++;
+
+            top[position] = candidate;
+
+            while (position > 0 && compare_top_records(&top[(position - 1) / 2], &top[position], keys) < 0) {
+                top_record swap = top[position];
+                top[position] = top[(position - 1) / 2];
+                top[(position - 1) / 2] = swap;
+                position = (position - 1) / 2;
+            }
+        } else if (compare_top_records(&candidate, &top[0], keys) < 0) {
+            top[0] = candidate;
+            sift_down_top_heap(top, size, 0, keys);
+        }
+
+        candidate.position++;
+    }
+
+    for (int end = size - 1; end > 0; end--) {
+        top_record swap = top[0];
+        top[0] = top[end];
+        top[end] = swap;
+        sift_down_top_heap(top, end, 0, keys);
+    }
+
+    return size;
+}
+
+FILE *top_records(FILE *working_file, char *working_file_name) {
+    sort_keys keys;
+    overlay_reader reader;
+    struct timespec start, finish;
+    char keys_text[256];
+    int k = 0, size = 0;
+    bool is_read_failed = false;
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    if (!input_sort_options(&keys, NUMBER_OF_SORTS)) {
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    format_sort_keys(keys_text, sizeof(keys_text), &keys);
+    system("clear");
+    printf("Top records by %s\n", keys_text);
+
+    do {
+        printf("\nEnter number of records [1; %i]: ", TOP_RECORDS_MAX);
+    } while (!input_int(&k) || k < 1 || k > TOP_RECORDS_MAX);
+
+    top_record *top = (top_record *) malloc(k * sizeof(top_record));
+    record **data = (record **) malloc(k * sizeof(record *));
+
+    lock_working_log(LOCK_SH);
+    refresh_working_log(working_file);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (top == NULL || data == NULL || !init_current_reader(&reader, working_file, working_file_name)) {
+        is_read_failed = true;
+    } else {
+        size = find_top_records(&reader, &keys, k, top);
+        free_overlay_reader(&reader);
+    }
+
+    unlock_working_log();
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    if (is_read_failed) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " Can't read file %s"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, working_file_name);
+    } else {
+        for (int i = 0; i < size; i++) {
+            data[i] = &top[i].data;
+        }
+
+        show_records(NOT_INTERACTIVE, working_file_name, size, data);
+
+        printf("\nTop %i records by %s, found in %.3lf s without changing the file", size, keys_text,
+               (double) (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9);
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    free(top);
+    free(data);
+
+    return working_file;
+}
+
+FILE *view_records(FILE *working_file, char *working_file_name) {
+    sort_keys keys;
+    char keys_text[256];
+    int size = 0, first = 1, last = 1;
+    bool is_loaded, is_saved = false;
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    if (!input_sort_options(&keys, 1)) {
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    lock_working_log(LOCK_SH);
+    refresh_working_log(working_file);
+
+    record **data = get_records_arr(working_file, &size);
+    int view_size = get_base_size(working_log->entries, working_log->size, size);
+    uint32_t *view = load_record_view(working_file_name, &keys, &working_log->header, view_size);
+
+    is_loaded = view != NULL;
+
+    if (is_loaded && working_log->size > 0) {
+        uint32_t *patched = (uint32_t *) malloc(size * sizeof(uint32_t) + 1);
+
+        is_loaded = patched != NULL && patch_record_view(view, view_size, working_log->entries, working_log->size,
+                                                         data, size, &keys, patched);
+        free(view);
+        view = patched;
+    }
+
+    if (!is_loaded) {
+        free(view);
+        view = (uint32_t *) malloc(size * sizeof(uint32_t) + 1);
+
+        if (view != NULL && sort_record_permutation(data, size, &keys, view)) {
+            is_saved = working_log->size == 0 &&
+                       save_record_view(working_file_name, &keys, &working_log->header, view, size);
+        } else {
+            free(view);
+            view = NULL;
+        }
+    }
+
+    unlock_working_log();
+
+    system("clear");
+
+    if (view == NULL || size == 0) {
+        printf("Error:" ITALIC_TEXT " %s"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, size == 0 ? "Empty file" : "Can't build the view");
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        free(view);
+        free_records_arr(data, size);
+        return working_file;
+    }
+
+    format_sort_keys(keys_text, sizeof(keys_text), &keys);
+    printf("View of %s by %s (%s)\n", working_file_name, keys_text,
+           is_loaded ? "read from the saved view" : is_saved ? "built and saved" : "built");
+
+    do {
+        printf("\nEnter first position [1; %i]: ", size);
+    } while (!input_int(&first) || first < 1 || first > size);
+
+    do {
+        printf("\nEnter last position [%i; %i]: ", first, size);
+    } while (!input_int(&last) || last < first || last > size);
+
+    uint64_t start = start_timer();
+
+    system("clear");
+    printf("Records %i-%i of %s by %s\n\n", first, last, working_file_name, keys_text);
+    printf("%-5s%-30s%-20s%-20s\n", "No.", "REGION NAME", "AREA SIZE", "POPULATION");
+
+    for (int i = first - 1; i < last; i++) {
+        show_record_row(NOT_INTERACTIVE, i, data[view[i]]);
+    }
+
+    stop_timer(RENDER_TIMER, start);
+
+    printf("\nThe file itself was not changed");
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    free(view);
+    free_records_arr(data, size);
+
+    return working_file;
+}
+
+FILE *bulk_change_records(FILE *working_file, char *working_file_name) {
+    int scanned = 0, changed = 0;
+    bool is_saved = false;
+    struct timespec start, finish;
+    record_filter filter = {"", area_min, area_max, population_min, population_max};
+    record_update update = {0};
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    system("clear");
+    printf("Bulk change of records in file %s\n", working_file_name);
+    printf("\nPress "GREEN_BG BLACK_TEXT"D"BLACK_BG GREEN_TEXT" to delete or "
+           GREEN_BG BLACK_TEXT"U"BLACK_BG GREEN_TEXT" to update the matching records "
+           "or any other button to return to the menu\n");
+
+    char mode = (char) toupper(key_pressed());
+
+    if (mode != 'D' && mode != 'U') {
+        printf("\nThe file was not changed");
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    input_record_filter(&filter);
+
+    if (mode == 'U') {
+        input_record_update(&update);
+
+        if (!update.is_name_set && !update.is_area_set && !update.is_population_set) {
+            printf("\nNothing to update, the file was not changed");
+            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+                   "close the program or any other button to return to the menu");
+            return working_file;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    working_file = rewrite_matching_records(working_file, working_file_name, &filter,
+                                            mode == 'U' ? &update : NULL, &scanned, &changed, &is_saved);
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    system("clear");
+
+    if (!is_saved) {
+        printf("Error:" ITALIC_TEXT " Can't rewrite the file %s, it was not changed"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, working_file_name);
+    } else {
+        printf("%s " GREEN_BG BLACK_TEXT "%i" BLACK_BG GREEN_TEXT " of %i records in %.2lf s",
+               mode == 'U' ? "Updated" : "Deleted", changed, scanned,
+               (double) (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9);
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    return working_file;
+}
+
+FILE *insert_record(FILE *working_file, char *working_file_name) {
+    int size = 0;
+    sort_keys keys;
+    char keys_text[256];
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        return working_file;
+    }
+
+    record **data = get_records_arr(working_file, &size);
+
+    if (size == 0) {
+        system("clear");
+
+        printf("Error:" ITALIC_TEXT " Empty file"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    if (!check_sort_order(data, size, &keys)) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " Records are not sorted"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        return working_file;
+    }
+
+
+    system("clear");
+    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+    format_sort_keys(keys_text, sizeof(keys_text), &keys);
+    printf("\nRecords are sorted " GREEN_BG BLACK_TEXT "by %s\n" BLACK_BG GREEN_TEXT, keys_text);
+
+    record input_data;
+
+    do {
+        printf("\nEnter name of region (max %i characters): ", REGION_NAME_MAX - 1);
+    } while (!string_input(input_data.region_name, REGION_NAME_MAX));
+
+    do {
+        printf("\nEnter size of region area [%.0lf; %.0lf]: ", area_min, area_max);
+    } while (!input_double(&input_data.region_area) ||
+             !is_correct_area(&input_data.region_area, area_min, area_max));
+
+    do {
+        printf("\nEnter population of region [%i; %i]: ", population_min, population_max);
+    } while (!input_int(&input_data.region_population) ||
+             !is_correct_population(&input_data.region_population,
+                                    population_min, population_max));
+
+    int insert_position = find_insert_position_by_keys((const record **) data, size, &input_data, &keys);
+
+    bool is_saved;
+
+    working_file = save_record_change(working_file, working_file_name, &data, &size,
+                                      WAL_INSERT, insert_position, NULL, &input_data, &is_saved);
+
+    system("clear");
+
+    if (is_saved) {
+        printf("\n Record was inserted successfully!\n");
+    } else {
+        printf("\nError:" ITALIC_TEXT " File was changed by another process, record was not inserted\n"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+    }
+
+    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    free_records_arr(data, size);
+
+    return working_file;
+}
+
+FILE *import_records(FILE *working_file, char *working_file_name) {
+    int imported = 0, rejected = 0;
+    int rejects_by_status[NUMBER_OF_RECORD_STATUSES] = {0};
+    bool is_header_checked = false, is_write_failed = false;
+    char path[PATH_SIZE];
+    enum record_status status;
+    struct timespec start, finish;
+    record_reader reader;
+    write_buffer buffer;
+    record input_data;
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    system("clear");
+    printf("Import records into file %s\n", working_file_name);
+
+    do {
+        printf("\nEnter path of CSV or TSV file (max %i characters): ", PATH_SIZE - 1);
+    } while (!string_input(path, PATH_SIZE));
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        printf("\nError:" ITALIC_TEXT " Can't open the file %s"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, path);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    if (!init_record_reader(&reader, fd) || !init_write_buffer(&buffer, working_file, WRITE_BUFFER_SIZE)) {
+        printf("\nError:" ITALIC_TEXT " Memory allocation failed"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        free_record_reader(&reader);
+        close(fd);
+        return working_file;
+    }
+
+    lock_working_log(LOCK_EX);
+
+    working_file = flush_working_log(working_file, working_file_name, 1);
+    buffer.file = working_file;
+
+    fseek(working_file, 0, SEEK_END);
+    long base_length = ftell(working_file);
+
+    if (working_log->fd != -1) {
+        wal_entry entry = make_wal_entry(WAL_IMPORT, 0, 0, NULL, NULL);
+
+        buffer.checksum = working_log->header.base_checksum;
+        is_write_failed = !log_record_change(&entry) || !commit_working_log();
+    }
+
+    printf("\n");
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (!is_write_failed && (status = read_next_record(&reader, &input_data)) != RECORD_END) {
+        if (status == RECORD_OK) {
+            status = validate_record(&input_data);
+        }
+
+        if (!is_header_checked) {
+            is_header_checked = true;
+
+            if (status == RECORD_BAD_AREA || status == RECORD_BAD_POPULATION) {
+                continue;
+            }
+        }
+
+        if (status != RECORD_OK) {
+            rejected++;
+            rejects_by_status[status]++;
+
+            if (rejected <= REJECTS_TO_SHOW) {
+                printf("Line %li rejected: " ITALIC_TEXT "%s\n" RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT,
+                       reader.line_number, record_status_names[status]);
+            }
+            continue;
+        }
+
+        if (!buffer_write_record(&buffer, &input_data)) {
+            is_write_failed = true;
+            break;
+        }
+
+        imported++;
+    }
+
+    if (!flush_write_buffer(&buffer) || fsync(fileno(working_file)) != 0) {
+        is_write_failed = true;
+    }
+
+    if (!is_write_failed && working_log->fd != -1) {
+        wal_header base = working_log->header;
+
+        fseek(working_file, 0, SEEK_END);
+        reset_working_log(buffer.checksum, ftell(working_file));
+        update_sorted_prefix(working_file_name, &base, NULL, 0, NULL, 0);
+        extend_line_index(working_file_name, &base, fileno(working_file));
+    } else if (is_write_failed && base_length >= 0) {
+        clearerr(working_file);
+        ftruncate(fileno(working_file), (off_t) base_length);
+
+        if (working_log->fd != -1) {
+            reset_working_log(working_log->header.base_checksum, working_log->header.base_length);
+        }
+    }
+
+    unlock_working_log();
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    free_write_buffer(&buffer);
+    free_record_reader(&reader);
+    close(fd);
+
+    if (is_write_failed) {
+        printf("\nError:" ITALIC_TEXT " Can't write to the file %s, the import was rolled back"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, working_file_name);
+    } else {
+        printf("\nImported " GREEN_BG BLACK_TEXT "%i" BLACK_BG GREEN_TEXT " records in %.2lf s",
+               imported, (double) (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9);
+    }
+
+    if (rejected > 0) {
+        printf("\nRejected %i lines:", rejected);
+
+        for (int i = RECORD_BAD_FIELDS; i < NUMBER_OF_RECORD_STATUSES; i++) {
+            if (rejects_by_status[i] > 0) {
+                printf("\n  %-25s%i", record_status_names[i], rejects_by_status[i]);
+            }
+        }
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    return working_file;
+}
+
+void show_export_formats(enum export_format current_option) {
+
+    printf("\nChoose export format\n");
+
+    for (int i = 0; i < NUMBER_OF_FORMATS; i++) {
+        printf("%s %s (.%s)%s\n",
+               ((int) current_option == i) ? GREEN_BG BLACK_TEXT "-->" : "",
+               export_format_names[i],
+               export_format_extensions[i],
+               ((int) current_option == i) ? BLACK_BG GREEN_TEXT : "");
+    }
+}
+
+bool input_sort_options(sort_keys *keys, int max_keys) {
+    bool is_chosen, is_exit = false, is_more_keys = true;
+    enum sort_option sort_option;
+    enum order_option order_option;
+    char keys_text[256] = "";
+
+    keys->size = 0;
+
+    while (is_more_keys) {
+        sort_option = NAME_SORT;
+        order_option = DESCENDING_ORDER;
+        is_chosen = false;
+
+        do {
+            system("clear");
+
+            if (keys->size > 0) {
+                printf("\nSorting by %s, then by\n", keys_text);
+            }
+
+            show_sort_options(sort_option);
+            sort_option = navigate_list(sort_option, NUMBER_OF_SORTS, &is_exit, &is_chosen);
+
+            if (is_exit) {
+                return false;
+            }
+        } while (!is_chosen);
+
+        is_chosen = false;
+
+        do {
+            system("clear");
+
+            if (keys->size > 0) {
+                printf("\nSorting by %s, then by\n", keys_text);
+            }
+
+            show_sort_options(sort_option);
+            show_order_options(order_option);
+            order_option = navigate_list(order_option, NUMBER_OF_ORDERS, &is_exit, &is_chosen);
+
+            if (is_exit) {
+                return false;
+            }
+        } while (!is_chosen);
+
+        add_sort_key(keys, sort_option, order_option);
+        format_sort_keys(keys_text, sizeof(keys_text), keys);
+        is_more_keys = false;
+
+        if (keys->size < max_keys) {
+            printf("\n\nPress "GREEN_BG BLACK_TEXT"T"BLACK_BG GREEN_TEXT" to add a tie-breaking key "
+                   "or any other button to continue\n");
+            is_more_keys = toupper(key_pressed()) == 'T';
+        }
+    }
+
+    return true;
+}
+
+void input_record_filter(record_filter *filter) {
+    do {
+        printf("\nEnter prefix of region name (empty for any, max %i characters): ", REGION_NAME_MAX - 1);
+    } while (!string_input(filter->name_prefix, REGION_NAME_MAX));
+
+    do {
+        printf("\nEnter minimal area [%.0lf; %.0lf]: ", area_min, area_max);
+    } while (!input_double(&filter->min_area) ||
+             !is_correct_area(&filter->min_area, area_min, area_max));
+
+    do {
+        printf("\nEnter maximal area [%.0lf; %.0lf]: ", filter->min_area, area_max);
+    } while (!input_double(&filter->max_area) ||
+             !is_correct_area(&filter->max_area, filter->min_area, area_max));
+
+    do {
+        printf("\nEnter minimal population [%i; %i]: ", population_min, population_max);
+    } while (!input_int(&filter->min_population) ||
+             !is_correct_population(&filter->min_population, population_min, population_max));
+
+    do {
+        printf("\nEnter maximal population [%i; %i]: ", filter->min_population, population_max);
+    } while (!input_int(&filter->max_population) ||
+             !is_correct_population(&filter->max_population, filter->min_population, population_max));
+}
+
+void input_record_update(record_update *update) {
+    printf("\nPress "GREEN_BG BLACK_TEXT"N"BLACK_BG GREEN_TEXT" to set the region name "
+           "or any other button to keep it\n");
+
+    if (toupper(key_pressed()) == 'N') {
+        update->is_name_set = true;
+
+        do {
+            printf("\nEnter name of region (max %i characters): ", REGION_NAME_MAX - 1);
+        } while (!string_input(update->data.region_name, REGION_NAME_MAX));
+    }
+
+    printf("\nPress "GREEN_BG BLACK_TEXT"A"BLACK_BG GREEN_TEXT" to set the area "
+           "or any other button to keep it\n");
+
+    if (toupper(key_pressed()) == 'A') {
+        update->is_area_set = true;
+
+        do {
+            printf("\nEnter size of region area [%.0lf; %.0lf]: ", area_min, area_max);
+        } while (!input_double(&update->data.region_area) ||
+                 !is_correct_area(&update->data.region_area, area_min, area_max));
+    }
+
+    printf("\nPress "GREEN_BG BLACK_TEXT"P"BLACK_BG GREEN_TEXT" to set the population "
+           "or any other button to keep it\n");
+
+    if (toupper(key_pressed()) == 'P') {
+        update->is_population_set = true;
+
+        do {
+            printf("\nEnter population of region [%i; %i]: ", population_min, population_max);
+        } while (!input_int(&update->data.region_population) ||
+                 !is_correct_population(&update->data.region_population, population_min, population_max));
+    }
+}
+
+void apply_record_update(record *data, const record_update *update) {
+    if (update->is_name_set) {
+        memcpy(data->region_name, update->data.region_name, sizeof(data->region_name));
+    }
+
+    if (update->is_area_set) {
+        data->region_area = update->data.region_area;
+    }
+
+    if (update->is_population_set) {
+        data->region_population = update->data.region_population;
+    }
+}
+
+FILE *export_records(FILE *working_file, char *working_file_name) {
+    int size = 0, scanned = 0, exported = 0;
+    bool is_chosen = false, is_exit = false, is_sorted_export = false, is_write_failed = false;
+    enum export_format current_format = CSV_FORMAT;
+    sort_keys keys;
+    enum record_status status;
+    struct timespec start, finish;
+    record_filter filter = {"", area_min, area_max, population_min, population_max};
+    write_buffer buffer;
+    columnar_writer columnar = {0};
+    record_reader reader;
+    record input_data;
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    do {
+        system("clear");
+        printf("Export records from file %s\n", working_file_name);
+        show_export_formats(current_format);
+        current_format = navigate_list(current_format, NUMBER_OF_FORMATS, &is_exit, &is_chosen);
+
+        if (is_exit) {
+            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+                   "close the program or any other button to return to the menu");
+            return working_file;
+        }
+    } while (!is_chosen);
+
+    printf("\nPress "GREEN_BG BLACK_TEXT"F"BLACK_BG GREEN_TEXT" to filter records "
+           "or any other button to export all of them\n");
+
+    if (toupper(key_pressed()) == 'F') {
+        input_record_filter(&filter);
+    }
+
+    printf("\nPress "GREEN_BG BLACK_TEXT"S"BLACK_BG GREEN_TEXT" to sort records "
+           "or any other button to keep the file order\n");
+
+    if (toupper(key_pressed()) == 'S') {
+        is_sorted_export = input_sort_options(&keys, NUMBER_OF_SORTS);
+    }
+
+    lock_working_log(LOCK_EX);
+
+    working_file = flush_working_log(working_file, working_file_name, 1);
+
+    char filepath[FILENAME_SIZE + strlen(working_folder) + 2];
+    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, working_file_name);
+
+    char export_filepath[strlen(working_file_name) + strlen(export_folder) + 8];
+    snprintf(export_filepath, sizeof(export_filepath), "%s/%.*s.%s", export_folder,
+             (int) strcspn(working_file_name, "."), working_file_name,
+             export_format_extensions[current_format]);
+
+    create_working_folder(export_folder);
+
+    FILE *export_file = fopen(export_filepath, "w");
+
+    system("clear");
+
+    if (export_file == NULL || !init_write_buffer(&buffer, export_file, WRITE_BUFFER_SIZE) ||
+        (current_format == COLUMNAR_FORMAT && !init_columnar_writer(&columnar, &buffer))) {
+        printf("Error:" ITALIC_TEXT " Can't create file %s"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, export_filepath);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        if (export_file != NULL) {
+            free_write_buffer(&buffer);
+            fclose(export_file);
+        }
+        unlock_working_log();
+        return working_file;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (current_format == BINARY_FORMAT) {
+        memcpy(buffer.data, BINARY_MAGIC, BINARY_MAGIC_SIZE);
+        buffer.size = BINARY_MAGIC_SIZE;
+    } else if (current_format == COLUMNAR_FORMAT) {
+        memcpy(buffer.data, COLUMNAR_MAGIC, COLUMNAR_MAGIC_SIZE);
+        buffer.size = COLUMNAR_MAGIC_SIZE;
+    } else if (current_format == CSV_FORMAT) {
+        buffer.size = sprintf(buffer.data, "region_name,region_area,region_population\n");
+    }
+
+    if (is_sorted_export) {
+        record **data = get_records_arr(working_file, &size);
+
+        if (data == NULL) {
+            is_write_failed = true;
+        } else {
+            sort_records_by_keys(data, size, &keys);
+
+            for (int i = 0; i < size && !is_write_failed; i++) {
+                if (matches_filter(data[i], &filter)) {
+                    is_write_failed = current_format == COLUMNAR_FORMAT
+                                      ? !add_columnar_record(&columnar, data[i])
+                                      : !buffer_write_export(&buffer, data[i], current_format);
+                    exported++;
+                }
+            }
+
+            scanned = size;
+            free_records_arr(data, size);
+        }
+    } else {
+        int fd = open(filepath, O_RDONLY);
+
+        if (fd == -1 || !init_record_reader(&reader, fd)) {
+            is_write_failed = true;
+        } else {
+            reader.delimiter = ' ';
+
+            while (!is_write_failed && (status = read_next_record(&reader, &input_data)) != RECORD_END) {
+                if (status != RECORD_OK && status != RECORD_BAD_NAME) {
+                    continue;
+                }
+
+                scanned++;
+
+                if (matches_filter(&input_data, &filter)) {
+                    is_write_failed = current_format == COLUMNAR_FORMAT
+                                      ? !add_columnar_record(&columnar, &input_data)
+                                      : !buffer_write_export(&buffer, &input_data, current_format);
+                    exported++;
+                }
+            }
+
+            free_record_reader(&reader);
+        }
+
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+
+    unlock_working_log();
+
+    if (current_format == COLUMNAR_FORMAT) {
+        is_write_failed = !finish_columnar_writer(&columnar) || is_write_failed;
+        free_columnar_writer(&columnar);
+    }
+
+    if (!flush_write_buffer(&buffer)) {
+        is_write_failed = true;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    long exported_bytes = ftell(export_file);
+    double seconds = (double) (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9;
+
+    free_write_buffer(&buffer);
+
+    if (fclose(export_file) || is_write_failed) {
+        printf("Error:" ITALIC_TEXT " Export to %s failed"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, export_filepath);
+    } else {
+        printf("Exported " GREEN_BG BLACK_TEXT "%i" BLACK_BG GREEN_TEXT " of %i records to %s "
+               "in %.2lf s (%.1lf MB/s)",
+               exported, scanned, export_filepath, seconds,
+               exported_bytes / 1e6 / (seconds > 0 ? seconds : 1));
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    return working_file;
+}
+
+bool is_merge_before(const record *current, int first, int second,
+                     enum sort_option sort_option, enum order_option order_option) {
+    int comparison_result = compare_records(&current[first], &current[second], sort_option, order_option);
+
+    return comparison_result < 0 || (comparison_result == 0 && first < second);
+}
+
+void sift_down_merge_heap(int *heap, int size, int position, const record *current,
+                          enum sort_option sort_option, enum order_option order_option) {
+    while (true) {
+        int smallest = position, left = 2 * position + 1, right = left + 1;
+
+        if (left < size && is_merge_before(current, heap[left], heap[smallest], sort_option, order_option)) {
+            smallest = left;
+        }
+
+        if (right < size && is_merge_before(current, heap[right], heap[smallest], sort_option, order_option)) {
+            smallest = right;
+        }
+
+        if (smallest == position) {
+            return;
+        }
+
+        int file = heap[position];
+        heap[position] = heap[smallest];
+        heap[smallest] = file;
+        position = smallest;
+    }
+}
+
+bool load_log_snapshot(log_snapshot *snapshot, const char *name, FILE *working_file, const char *working_file_name) {
+    write_ahead_log log = {.fd = -1}, *previous = working_log;
+    char log_filepath[PATH_SIZE + NAME_MAX];
+    struct stat data_stat;
+    bool is_working_file = working_file != NULL && strcmp(name, working_file_name) == 0;
+    int size = 0;
+
+    memset(snapshot, 0, sizeof(log_snapshot));
+    snapshot->records = INT_MAX;
+
+    if (!is_working_file) {
+        if (snprintf(log.data_path, sizeof(log.data_path), "%s/%s", working_folder, name) >=
+            (int) sizeof(log.data_path)) {
+            return false;
+        }
+
+        get_sidecar_filepath(log_filepath, sizeof(log_filepath), name, "wal");
+        log.fd = open(log_filepath, O_RDONLY);
+        working_log = &log;
+    }
+
+    lock_working_log(LOCK_SH);
+
+    snapshot->file = fopen(working_log->data_path, "r");
+
+    if (snapshot->file != NULL && is_working_file) {
+        refresh_working_log(working_file);
+        size = working_file == working_log->data_file ? working_log->size : 0;
+    } else if (snapshot->file != NULL) {
+        log.data_file = snapshot->file;
+        refresh_working_log(snapshot->file);
+
+        if (fstat(fileno(snapshot->file), &data_stat) == 0 &&
+            log.header.base_length == (uint64_t) data_stat.st_size) {
+            size = log.size;
+        }
+    }
+
+    if (size > 0) {
+        snapshot->entries = (wal_entry *) malloc(size * sizeof(wal_entry));
+        snapshot->records = count_base_records(is_working_file ? working_file : snapshot->file, name);
+
+        if (snapshot->entries != NULL) {
+            memcpy(snapshot->entries, working_log->entries, size * sizeof(wal_entry));
+            snapshot->size = size;
+        }
+    }
+
+    bool is_loaded = snapshot->file != NULL && snapshot->records >= 0 && snapshot->size == size;
+
+    unlock_working_log();
+    working_log = previous;
+
+    if (log.fd != -1) {
+        close(log.fd);
+    }
+
+    free(log.entries);
+
+    return is_loaded;
+}
+
+void free_log_snapshot(log_snapshot *snapshot) {
+    if (snapshot->file != NULL) {
+        fclose(snapshot->file);
+    }
+
+    free(snapshot->entries);
+    memset(snapshot, 0, sizeof(log_snapshot));
+}
+
+bool open_merge_input(overlay_reader *reader, FILE **file, const char *name,
+                      FILE *working_file, const char *working_file_name) {
+    log_snapshot snapshot;
+    bool is_opened = load_log_snapshot(&snapshot, name, working_file, working_file_name) &&
+                     init_overlay_reader(reader, fileno(snapshot.file), snapshot.records,
+                                         snapshot.entries, snapshot.size);
+
+    *file = snapshot.file;
+    snapshot.file = NULL;
+    free_log_snapshot(&snapshot);
+
+    return is_opened;
+}
+
+FILE *merge_files(FILE *working_file, char *working_file_name) {
+    char names[MERGE_FILES_MAX][NAME_MAX + 1], chosen_name[NAME_MAX + 1], title[256], filename[FILENAME_SIZE];
+    bool is_ordered[NUMBER_OF_SORTS][NUMBER_OF_ORDERS], is_common[NUMBER_OF_SORTS][NUMBER_OF_ORDERS];
+    bool is_exit = false, is_write_failed = false;
+    int num_of_files = 0, sort_option = -1, order_option = 0, heap_size = 0;
+    long merged = 0;
+    int heap[MERGE_FILES_MAX];
+    record current[MERGE_FILES_MAX];
+    overlay_reader readers[MERGE_FILES_MAX];
+    FILE *files[MERGE_FILES_MAX];
+    struct timespec start, finish;
+    write_buffer buffer;
+
+    do {
+        snprintf(title, sizeof(title), "Merge files: %i of at most %i chosen. Choose the next file "
+                                       "or press ESC to finish", num_of_files, MERGE_FILES_MAX);
+
+        if (browse_catalog(title, chosen_name, &is_exit) == 0) {
+            break;
+        }
+
+        bool is_duplicate = false;
+
+        for (int i = 0; i < num_of_files && !is_exit; i++) {
+            is_duplicate = is_duplicate || strcmp(names[i], chosen_name) == 0;
+        }
+
+        if (!is_exit && !is_duplicate) {
+            strcpy(names[num_of_files++], chosen_name);
+        }
+    } while (!is_exit && num_of_files < MERGE_FILES_MAX);
+
+    system("clear");
+
+    if (num_of_files < 2) {
+        printf("Error:" ITALIC_TEXT " Choose at least two files to merge"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    memset(is_common, true, sizeof(is_common));
+    printf("Files to merge:\n");
+
+    for (int i = 0; i < num_of_files; i++) {
+        long size = -1;
+
+        if (open_merge_input(&readers[i], &files[i], names[i], working_file, working_file_name)) {
+            size = get_reader_sort_orders(&readers[i], is_ordered);
+            free_overlay_reader(&readers[i]);
+        }
+
+        if (files[i] != NULL) {
+            fclose(files[i]);
+        }
+
+        if (size < 0) {
+            printf("\nError:" ITALIC_TEXT " Can't read the file %s"
+                   RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, names[i]);
+            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+                   "close the program or any other button to return to the menu");
+            return working_file;
+        }
+
+        printf("%s (%li records)\n", names[i], size);
+
+        for (int sort = 0; sort < NUMBER_OF_SORTS; sort++) {
+            for (int order = 0; order < NUMBER_OF_ORDERS; order++) {
+                is_common[sort][order] = is_common[sort][order] && is_ordered[sort][order];
+            }
+        }
+    }
+
+    for (int sort = NUMBER_OF_SORTS - 1; sort >= 0; sort--) {
+        for (int order = NUMBER_OF_ORDERS - 1; order >= 0; order--) {
+            if (is_common[sort][order]) {
+                sort_option = sort;
+                order_option = order;
+            }
+        }
+    }
+
+    if (sort_option < 0) {
+        printf("\nError:" ITALIC_TEXT " The files are not sorted by the same key and order"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        return working_file;
+    }
+
+    printf("\nAll files are sorted by %s in %s\n", sort_option_names[sort_option], order_option_names[order_option]);
+
+    do {
+        printf("\nEnter the name of the merged file (max %i characters): ", FILENAME_SIZE - 1);
+    } while (!string_input(filename, FILENAME_SIZE) || !is_valid_filename(filename));
+
+    char filepath[PATH_SIZE + NAME_MAX];
+    snprintf(filepath, sizeof(filepath), "%s/%s.txt", working_folder, filename);
+
+    int output_fd = open(filepath, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    FILE *output = output_fd != -1 ? fdopen(output_fd, "w") : NULL;
+
+    if (output == NULL || !init_write_buffer(&buffer, output, WRITE_BUFFER_SIZE)) {
+        printf("\nError:" ITALIC_TEXT " Can't create the file %s.txt"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, filename);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        if (output != NULL) {
+            fclose(output);
+            remove(filepath);
+        } else if (output_fd != -1) {
+            close(output_fd);
+            remove(filepath);
+        }
+        return working_file;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int i = 0; i < num_of_files; i++) {
+        if (!open_merge_input(&readers[i], &files[i], names[i], working_file, working_file_name)) {
+            memset(&readers[i], 0, sizeof(overlay_reader));
+            is_write_failed = true;
+            continue;
+        }
+
+        if (read_overlay_record(&readers[i], &current[i])) {
+            heap[heap_size++] = i;
+        }
+    }
+
+    for (int position = heap_size / 2 - 1; position >= 0; position--) {
+        sift_down_merge_heap(heap, heap_size, position, current, sort_option, order_option);
+    }
+
+    while (heap_size > 0 && !is_write_failed) {
+        int file = heap[0];
+
+        is_write_failed = !buffer_write_record(&buffer, &current[file]);
+        merged++;
+
+        if (!read_overlay_record(&readers[file], &current[file])) {
+            heap[0] = heap[--heap_size];
+        }
+
+        sift_down_merge_heap(heap, heap_size, 0, current, sort_option, order_option);
+    }
+
+    for (int i = 0; i < num_of_files; i++) {
+        free_overlay_reader(&readers[i]);
+
+        if (files[i] != NULL) {
+            fclose(files[i]);
+        }
+    }
+
+    is_write_failed = !flush_write_buffer(&buffer) || fsync(fileno(output)) != 0 || is_write_failed;
+    free_write_buffer(&buffer);
+    is_write_failed = fclose(output) != 0 || is_write_failed;
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    double seconds = (double) (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (is_write_failed) {
+        remove(filepath);
+        printf("\nError:" ITALIC_TEXT " Merge into %s.txt failed"
                RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, filename);
+    } else {
+        sync_working_folder();
+        printf("\nMerged " GREEN_BG BLACK_TEXT "%li" BLACK_BG GREEN_TEXT " records from %i files into %s.txt "
+               "in %.2lf s", merged, num_of_files, filename, seconds);
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    return working_file;
+}
+
+void add_query_totals(query_totals *totals, const query_totals *other) {
+    if (other->count == 0) {
+        return;
+    }
+
+    if (totals->count == 0 || other->min_area < totals->min_area) {
+        totals->min_area = other->min_area;
+    }
+
+    if (totals->count == 0 || other->max_area > totals->max_area) {
+        totals->max_area = other->max_area;
+    }
+
+    if (totals->count == 0 || other->min_population < totals->min_population) {
+        totals->min_population = other->min_population;
+    }
+
+    if (totals->count == 0 || other->max_population > totals->max_population) {
+        totals->max_population = other->max_population;
+    }
+
+    totals->count += other->count;
+    totals->area_sum += other->area_sum;
+    totals->population_sum += other->population_sum;
+}
+
+void run_query_task(cross_file_query *query, query_task *task) {
+    record_reader reader;
+    overlay_reader overlay;
+    record input_data;
+
+    char filepath[PATH_SIZE + NAME_MAX];
+    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, query->names[task->file]);
+
+    log_snapshot *log = &query->logs[task->file];
+    int fd = task->is_overlay ? fileno(log->file) : open(filepath, O_RDONLY);
+    off_t offset = task->start > 0 ? task->start - 1 : 0;
+
+    if (fd == -1 || (task->is_overlay
+                     ? !init_overlay_reader(&overlay, fd, log->records, log->entries, log->size)
+                     : !init_record_reader_at(&reader, fd, offset, task->end))) {
+        task->is_failed = true;
+
+        if (fd != -1 && !task->is_overlay) {
+            close(fd);
+        }
+        return;
+    }
+
+    reader.delimiter = ' ';
+
+    if (task->start > 0 && !task->is_overlay) {
+        read_line(&reader);
+    }
+
+    while (task->is_overlay ? read_overlay_record(&overlay, &input_data) : read_valid_record(&reader, &input_data)) {
+        if (!matches_filter(&input_data, &query->filter)) {
+            continue;
+        }
+
+        if (task->size >= task->capacity) {
+            int capacity = task->capacity ? task->capacity * 2 : 64;
+            record *results = (record *) realloc(task->results, capacity * sizeof(record));
+
+            if (results == NULL) {
+                task->is_failed = true;
+                break;
+            }
+
+            task->results = results;
+            task->capacity = capacity;
+        }
+
+        query_totals totals = {1, input_data.region_area, input_data.region_population,
+                               input_data.region_area, input_data.region_area,
+                               input_data.region_population, input_data.region_population};
+
+        task->results[task->size++] = input_data;
+        add_query_totals(&task->totals, &totals);
+    }
+
+    if (task->is_overlay) {
+        free_overlay_reader(&overlay);
+    } else {
+        free_record_reader(&reader);
+        close(fd);
+    }
+}
+
+int take_query_task(cross_file_query *query, int worker) {
+    task_deque *own = &query->deques[worker];
+    int task = -1;
+
+    pthread_mutex_lock(&own->mutex);
+
+    if (own->bottom > own->top) {
+        task = own->tasks[--own->bottom];
+    }
+
+    pthread_mutex_unlock(&own->mutex);
+
+    for (int i = 1; i < query->num_of_workers && task == -1; i++) {
+        task_deque *victim = &query->deques[(worker + i) % query->num_of_workers];
+
+        pthread_mutex_lock(&victim->mutex);
+
+        if (victim->bottom > victim->top) {
+            task = victim->tasks[victim->top++];
+        }
+
+        pthread_mutex_unlock(&victim->mutex);
+    }
+
+    return task;
+}
+
+void *query_worker(void *argument) {
+    query_worker_argument *worker = (query_worker_argument *) argument;
+    cross_file_query *query = worker->query;
+    int task;
+
+    while ((task = take_query_task(query, worker->index)) != -1) {
+        uint64_t span = begin_span();
+
+        run_query_task(query, &query->tasks[task]);
+        end_span("query task", span);
+
+        pthread_mutex_lock(&query->mutex);
+        query->tasks[task].is_done = true;
+        pthread_cond_broadcast(&query->task_done);
+        pthread_mutex_unlock(&query->mutex);
+    }
+
+    return NULL;
+}
+
+void show_query_totals(const char *title, const query_totals *totals) {
+    if (totals->count == 0) {
+        printf("%-16s%12i\n", title, 0);
+        return;
+    }
+
+    printf("%-16s%12li%20.3lf%20lld%16.3lf%16.3lf%12i%12i\n", title, totals->count, totals->area_sum,
+           totals->population_sum, totals->min_area, totals->max_area,
+           totals->min_population, totals->max_population);
+}
+
+FILE *query_files(FILE *working_file, char *working_file_name) {
+    cross_file_query query = {.mutex = PTHREAD_MUTEX_INITIALIZER, .task_done = PTHREAD_COND_INITIALIZER};
+    query_totals *file_totals, totals = {0};
+    query_worker_argument arguments[QUERY_THREADS_MAX];
+    pthread_t workers[QUERY_THREADS_MAX];
+    struct timespec start, finish;
+    write_buffer buffer;
+    int num_of_files = 0, shown = 0, capacity = 0, started = 0;
+    bool is_write_failed = false, is_failed = false;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    query.filter = (record_filter) {"", area_min, area_max, population_min, population_max};
+
+    system("clear");
+    printf("Query all files in %s\n", working_folder);
+
+    input_record_filter(&query.filter);
+
+    query.names = get_filenames_arr(&num_of_files);
+
+    if (query.names == NULL || num_of_files == 0) {
+        printf("\nError:" ITALIC_TEXT " Empty folder"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        if (query.names != NULL) {
+            free_filenames_arr(query.names, num_of_files);
+        }
+        return working_file;
+    }
+
+    char export_filepath[PATH_SIZE];
+    snprintf(export_filepath, sizeof(export_filepath), "%s/query.txt", export_folder);
+    create_working_folder(export_folder);
+
+    FILE *export_file = fopen(export_filepath, "w");
+    file_totals = (query_totals *) calloc(num_of_files, sizeof(query_totals));
+    query.logs = (log_snapshot *) calloc(num_of_files, sizeof(log_snapshot));
+
+    if (export_file == NULL || file_totals == NULL || query.logs == NULL ||
+        !init_write_buffer(&buffer, export_file, WRITE_BUFFER_SIZE)) {
+        printf("\nError:" ITALIC_TEXT " Can't create file %s"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, export_filepath);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        if (export_file != NULL) {
+            fclose(export_file);
+        }
+        free(file_totals);
+        free(query.logs);
+        free_filenames_arr(query.names, num_of_files);
+        return working_file;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int i = 0; i < num_of_files && !is_failed; i++) {
+        char filepath[PATH_SIZE + NAME_MAX], magic[COLUMNAR_MAGIC_SIZE];
+        struct stat file_stat;
+
+        if (!load_log_snapshot(&query.logs[i], query.names[i], working_file, working_file_name)) {
+            free_log_snapshot(&query.logs[i]);
+            continue;
+        }
+
+        bool is_overlay = query.logs[i].size > 0;
+
+        if (!is_overlay) {
+            free_log_snapshot(&query.logs[i]);
+        }
+
+        snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, query.names[i]);
+
+        int fd = open(filepath, O_RDONLY);
+
+        if (fd == -1 || fstat(fd, &file_stat) != 0) {
+            if (fd != -1) {
+                close(fd);
+            }
+            continue;
+        }
+
+        bool is_columnar = pread(fd, magic, COLUMNAR_MAGIC_SIZE, 0) == COLUMNAR_MAGIC_SIZE &&
+                           memcmp(magic, COLUMNAR_MAGIC, COLUMNAR_MAGIC_SIZE) == 0;
+        off_t chunk_size = is_columnar || is_overlay || file_stat.st_size == 0 ? file_stat.st_size + 1
+                                                                               : QUERY_CHUNK_SIZE;
+
+        close(fd);
+
+        for (off_t offset = 0; offset < file_stat.st_size || offset == 0; offset += chunk_size) {
+            if (query.num_of_tasks >= capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                query_task *tasks = (query_task *) realloc(query.tasks, capacity * sizeof(query_task));
+
+                if (tasks == NULL) {
+                    is_failed = true;
+                    break;
+                }
+
+                query.tasks = tasks;
+            }
+
+            query.tasks[query.num_of_tasks++] = (query_task) {.file = i, .start = offset, .is_overlay = is_overlay,
+                                                              .end = is_columnar ? -1 : offset + chunk_size};
+        }
+    }
+
+    query.num_of_workers = threads < 1 ? 1 : threads > QUERY_THREADS_MAX ? QUERY_THREADS_MAX : (int) threads;
+
+    if (query.num_of_workers > query.num_of_tasks) {
+        query.num_of_workers = query.num_of_tasks > 0 ? query.num_of_tasks : 1;
+    }
+
+    for (int i = 0; i < query.num_of_workers; i++) {
+        task_deque *deque = &query.deques[i];
+
+        deque->tasks = (int *) malloc((query.num_of_tasks / query.num_of_workers + 1) * sizeof(int));
+        deque->top = 0;
+        deque->bottom = 0;
+        pthread_mutex_init(&deque->mutex, NULL);
+        is_failed = is_failed || deque->tasks == NULL;
+
+        for (int task = query.num_of_tasks - 1 - i; task >= 0 && deque->tasks != NULL; task -= query.num_of_workers) {
+            deque->tasks[deque->bottom++] = task;
+        }
+    }
+
+    for (int i = 0; i < query.num_of_workers && is_failed; i++) {
+        query.deques[i].bottom = 0;
+        query.num_of_tasks = 0;
+    }
+
+    for (int i = 0; i < query.num_of_workers; i++) {
+        arguments[i] = (query_worker_argument) {&query, i};
+
+        if (pthread_create(&workers[i], NULL, query_worker, &arguments[i]) != 0) {
+            break;
+        }
+
+        started++;
+    }
+
+    if (started == 0) {
+        query_worker(&arguments[0]);
+    }
+
+    printf("\n%-22s%-22s%16s%14s\n", "FILE", "REGION NAME", "AREA SIZE", "POPULATION");
+
+    for (int i = 0; i < query.num_of_tasks; i++) {
+        query_task *task = &query.tasks[i];
+
+        pthread_mutex_lock(&query.mutex);
+
+        while (!task->is_done) {
+            pthread_cond_wait(&query.task_done, &query.mutex);
+        }
+
+        pthread_mutex_unlock(&query.mutex);
+
+        for (int j = 0; j < task->size && !is_write_failed; j++) {
+            is_write_failed = !buffer_write_record(&buffer, &task->results[j]);
+
+            if (shown < QUERY_RESULTS_TO_SHOW) {
+                printf("%-22s%-22s%16.3lf%14i\n", query.names[task->file], task->results[j].region_name,
+                       task->results[j].region_area, task->results[j].region_population);
+                shown++;
+            }
+        }
+
+        is_failed = is_failed || task->is_failed;
+        add_query_totals(&file_totals[task->file], &task->totals);
+        add_query_totals(&totals, &task->totals);
+        free(task->results);
+        task->results = NULL;
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    for (int i = 0; i < num_of_files; i++) {
+        free_log_snapshot(&query.logs[i]);
+    }
+
+    for (int i = 0; i < query.num_of_workers; i++) {
+        free(query.deques[i].tasks);
+        pthread_mutex_destroy(&query.deques[i].mutex);
+    }
+
+    is_write_failed = !flush_write_buffer(&buffer) || is_write_failed;
+    free_write_buffer(&buffer);
+    is_write_failed = fclose(export_file) != 0 || is_write_failed;
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    double seconds = (double) (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (totals.count > shown) {
+        printf("... and %li more\n", totals.count - shown);
+    }
+
+    printf("\n%-16s%12s%20s%20s%16s%16s%12s%12s\n", "FILE", "MATCHES", "TOTAL AREA", "TOTAL POPULATION",
+           "MIN AREA", "MAX AREA", "MIN POP.", "MAX POP.");
+
+    for (int i = 0; i < num_of_files; i++) {
+        if (file_totals[i].count > 0) {
+            show_query_totals(query.names[i], &file_totals[i]);
+        }
+    }
+
+    show_query_totals("ALL FILES", &totals);
+
+    if (is_failed || is_write_failed) {
+        printf("\nError:" ITALIC_TEXT " Some files could not be read or results could not be written"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+    }
+
+    printf("\nQueried %i files in %i tasks on %i threads in %.2lf s, matching records were written to %s",
+           num_of_files, query.num_of_tasks, query.num_of_workers, seconds, export_filepath);
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    free(query.tasks);
+    free(query.logs);
+    free(file_totals);
+    free_filenames_arr(query.names, num_of_files);
+
+    return working_file;
+}
+
+bool aggregate_group_partition(group_query *query, int partition, int start, int end) {
+    name_pool pool;
+    record_group *groups = NULL;
+    int size = 0, capacity = 0;
+
+    if (!init_name_pool(&pool, end - start)) {
+        return false;
+    }
+
+    for (int i = start; i < end; i++) {
+        int position = query->order[i];
+        const record *data = query->data[position];
+        int id = intern_name(&pool, data->region_name);
+
+        if (id == -1) {
+            free_name_pool(&pool);
+            free(groups);
+            return false;
+        }
+
+        if (id == size) {
+            if (size >= capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                record_group *grown = (record_group *) realloc(groups, capacity * sizeof(record_group));
+
+                if (grown == NULL) {
+                    free_name_pool(&pool);
+                    free(groups);
+                    return false;
+                }
+
+                groups = grown;
+            }
+
+            groups[size++] = (record_group) {data->region_name, position, position, {0}};
+        }
+
+        query_totals totals = {1, data->region_area, data->region_population,
+                               data->region_area, data->region_area,
+                               data->region_population, data->region_population};
+
+        add_query_totals(&groups[id].totals, &totals);
+        groups[id].last = position;
+    }
+
+    free_name_pool(&pool);
+
+    query->groups[partition] = groups;
+    query->num_of_groups[partition] = size;
+
+    return true;
+}
+
+void *group_worker(void *argument) {
+    group_worker_argument *worker = (group_worker_argument *) argument;
+    group_query *query = worker->query;
+
+    pthread_mutex_lock(&query->start_mutex);
+    pthread_mutex_unlock(&query->start_mutex);
+
+    int workers = query->num_of_workers, index = worker->index;
+    int first = (int) ((long long) query->size * index / workers);
+    int last = (int) ((long long) query->size * (index + 1) / workers);
+    int *counts = query->counts + index * workers;
+    int offsets[GROUP_THREADS_MAX], start = 0, length = 0;
+    uint64_t span = begin_span();
+
+    for (int i = first; i < last; i++) {
+        query->hashes[i] = hash_name(query->data[i]->region_name);
+        counts[((uint64_t) query->hashes[i] * workers) >> 32]++;
+    }
+
+    pthread_barrier_wait(&query->barrier);
+
+    for (int partition = 0, offset = 0; partition < workers; partition++) {
+        for (int other = 0; other < workers; other++) {
+            if (other == index) {
+                offsets[partition] = offset;
+            }
+
+            if (partition < index) {
+                start += query->counts[other * workers + partition];
+            } else if (partition == index) {
+                length += query->counts[other * workers + partition];
+            }
+
+            offset += query->counts[other * workers + partition];
+        }
+    }
+
+    for (int i = first; i < last; i++) {
+        query->order[offsets[((uint64_t) query->hashes[i] * workers) >> 32]++] = i;
+    }
+
+    pthread_barrier_wait(&query->barrier);
+
+    if (!aggregate_group_partition(query, index, start, start + length)) {
+        query->num_of_groups[index] = -1;
+    }
+
+    end_span("group partition", span);
+
+    return NULL;
+}
+
+int compare_record_groups(const void *first, const void *second) {
+    return ((const record_group *) first)->first - ((const record_group *) second)->first;
+}
+
+record_group *group_records(record **data, int size, int *num_of_groups) {
+    group_query query = {.data = data, .size = size};
+    group_worker_argument arguments[GROUP_THREADS_MAX];
+    pthread_t workers[GROUP_THREADS_MAX];
+    record_group *groups = NULL;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int total = 0, started = 1;
+
+    query.num_of_workers = size < GROUP_PARALLEL_MIN || threads < 1 ? 1 :
+                           threads > GROUP_THREADS_MAX ? GROUP_THREADS_MAX : (int) threads;
+    query.hashes = (uint32_t *) malloc(size * sizeof(uint32_t) + 1);
+    query.order = (int *) malloc(size * sizeof(int) + 1);
+    query.counts = (int *) calloc(query.num_of_workers * query.num_of_workers, sizeof(int));
+    query.groups = (record_group **) calloc(query.num_of_workers, sizeof(record_group *));
+    query.num_of_groups = (int *) calloc(query.num_of_workers, sizeof(int));
+
+    bool is_grouped = query.hashes != NULL && query.order != NULL && query.counts != NULL &&
+                      query.groups != NULL && query.num_of_groups != NULL;
+
+    if (is_grouped) {
+        for (int i = 0; i < query.num_of_workers; i++) {
+            arguments[i] = (group_worker_argument) {&query, i};
+        }
+
+        pthread_mutex_init(&query.start_mutex, NULL);
+        pthread_mutex_lock(&query.start_mutex);
+
+        while (started < query.num_of_workers &&
+               pthread_create(&workers[started], NULL, group_worker, &arguments[started]) == 0) {
+            started++;
+        }
+
+        query.num_of_workers = started;
+        pthread_barrier_init(&query.barrier, NULL, started);
+        pthread_mutex_unlock(&query.start_mutex);
+
+        group_worker(&arguments[0]);
+
+        for (int i = 1; i < started; i++) {
+            pthread_join(workers[i], NULL);
+        }
+
+        pthread_barrier_destroy(&query.barrier);
+        pthread_mutex_destroy(&query.start_mutex);
+    }
+
+    for (int i = 0; i < query.num_of_workers && is_grouped; i++) {
+        is_grouped = query.num_of_groups[i] != -1;
+        total += query.num_of_groups[i];
+    }
+
+    if (is_grouped) {
+        groups = (record_group *) malloc(total * sizeof(record_group) + 1);
+    }
+
+    if (groups != NULL) {
+        for (int i = 0, offset = 0; i < query.num_of_workers; i++) {
+            memcpy(groups + offset, query.groups[i], query.num_of_groups[i] * sizeof(record_group));
+            offset += query.num_of_groups[i];
+        }
+
+        qsort(groups, total, sizeof(record_group), compare_record_groups);
+        *num_of_groups = total;
+    }
+
+    for (int i = 0; i < query.num_of_workers && query.groups != NULL; i++) {
+        free(query.groups[i]);
+    }
+
+    free(query.hashes);
+    free(query.order);
+    free(query.counts);
+    free(query.groups);
+    free(query.num_of_groups);
+
+    return groups;
+}
+
+FILE *compact_records(FILE *working_file, char *working_file_name, record **data, int size,
+                      const record_group *groups, int num_of_groups, bool *is_saved) {
+    sort_keys keys;
+    int prefix = 0, sorted_prefix = 0, kept = 0;
+    bool *is_kept = (bool *) calloc(size + 1, sizeof(bool));
+    record **kept_data = (record **) malloc((num_of_groups + 1) * sizeof(record *));
+
+    *is_saved = false;
+
+    if (is_kept == NULL || kept_data == NULL) {
+        free(is_kept);
+        free(kept_data);
+        return working_file;
+    }
+
+    bool is_tracked = load_sorted_prefix(working_file_name, &working_log->header, working_log->entries,
+                                         working_log->size, &keys, &prefix);
+    uint64_t checkpoints = working_log->checkpoints;
+
+    for (int i = 0; i < num_of_groups; i++) {
+        is_kept[groups[i].last] = true;
+    }
+
+    for (int i = 0; i < size; i++) {
+        if (is_kept[i]) {
+            sorted_prefix += i < prefix;
+            kept_data[kept++] = data[i];
+        }
+    }
+
+    working_file = checkpoint_working_file(working_file, working_file_name, kept_data, kept);
+
+    if (working_log->checkpoints != checkpoints) {
+        *is_saved = true;
+
+        if (is_tracked) {
+            save_sorted_prefix(working_file_name, &working_log->header, &keys, sorted_prefix);
+        }
+    }
+
+    free(is_kept);
+    free(kept_data);
+
+    return working_file;
+}
+
+FILE *group_by_name(FILE *working_file, char *working_file_name) {
+    int size = 0, num_of_groups = 0;
+    bool is_saved = false;
+    struct timespec start, finish;
+
+    if (working_file == NULL) {
+        system("clear");
+        printf("Error:" ITALIC_TEXT " No file was opened"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
         printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
                "close the program or any other button to return to the menu");
-        return;
+        return working_file;
+    }
+
+    system("clear");
+    printf("Group records of file %s by region name\n", working_file_name);
+    printf("\nPress "GREEN_BG BLACK_TEXT"C"BLACK_BG GREEN_TEXT" to also compact the file to the last record "
+           "of every region name or any other button to only show the groups\n");
+
+    bool is_compacting = toupper(key_pressed()) == 'C';
+
+    if (is_compacting) {
+        lock_working_log(LOCK_EX);
     }
 
-    file = fopen(filepath, "w");
+    record **data = get_records_arr(working_file, &size);
 
-    if (file == NULL) {
-        printf("\nError:" ITALIC_TEXT " Cant open the file"
+    if (data == NULL || size == 0) {
+        if (is_compacting) {
+            unlock_working_log();
+        }
+
+        system("clear");
+        printf("Error:" ITALIC_TEXT " Empty file"
                RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
         printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
                "close the program or any other button to return to the menu");
-        return;
+        free_records_arr(data, size);
+        return working_file;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    record_group *groups = group_records(data, size, &num_of_groups);
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    if (is_compacting && groups != NULL && num_of_groups < size) {
+        working_file = compact_records(working_file, working_file_name, data, size, groups, num_of_groups, &is_saved);
+    }
+
+    if (is_compacting) {
+        unlock_working_log();
+    }
+
+    system("clear");
+
+    if (groups == NULL) {
+        printf("Error:" ITALIC_TEXT " Memory allocation failed"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+               "close the program or any other button to return to the menu");
+        free_records_arr(data, size);
+        return working_file;
+    }
+
+    char export_filepath[strlen(working_file_name) + strlen(export_folder) + 16];
+    snprintf(export_filepath, sizeof(export_filepath), "%s/%.*s.groups.csv", export_folder,
+             (int) strcspn(working_file_name, "."), working_file_name);
+
+    create_working_folder(export_folder);
+
+    FILE *export_file = fopen(export_filepath, "w");
+    bool is_write_failed = export_file == NULL;
+
+    if (export_file != NULL) {
+        fprintf(export_file, "region_name,count,area_sum,area_min,area_max,area_avg,"
+                             "population_sum,population_min,population_max,population_avg\n");
+    }
+
+    printf("%-22s%8s%14s%12s%12s%12s%14s%12s%12s%12s\n", "REGION NAME", "COUNT", "TOTAL AREA", "MIN AREA",
+           "MAX AREA", "AVG AREA", "TOTAL POP.", "MIN POP.", "MAX POP.", "AVG POP.");
+
+    for (int i = 0; i < num_of_groups; i++) {
+        const query_totals *totals = &groups[i].totals;
+
+        if (i < GROUPS_TO_SHOW) {
+            printf("%-22s%8li%14.3lf%12.3lf%12.3lf%12.3lf%14lld%12i%12i%12.1lf\n", groups[i].name,
+                   totals->count, totals->area_sum, totals->min_area, totals->max_area,
+                   totals->area_sum / totals->count, totals->population_sum, totals->min_population,
+                   totals->max_population, (double) totals->population_sum / totals->count);
+        }
+
+        if (export_file != NULL) {
+            is_write_failed = fprintf(export_file, "%s,%li,%.6lf,%.6lf,%.6lf,%.6lf,%lld,%i,%i,%.6lf\n",
+                                      groups[i].name, totals->count, totals->area_sum, totals->min_area,
+                                      totals->max_area, totals->area_sum / totals->count,
+                                      totals->population_sum, totals->min_population, totals->max_population,
+                                      (double) totals->population_sum / totals->count) < 0 || is_write_failed;
+        }
+    }
+
+    if (num_of_groups > GROUPS_TO_SHOW) {
+        printf("... and %i more\n", num_of_groups - GROUPS_TO_SHOW);
+    }
+
+    if (export_file != NULL) {
+        is_write_failed = fclose(export_file) != 0 || is_write_failed;
+    }
+
+    if (is_write_failed) {
+        printf("\nError:" ITALIC_TEXT " Can't write the file %s"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, export_filepath);
+    }
+
+    printf("\nGrouped %i records into %i region names in %.2lf s, all groups were written to %s",
+           size, num_of_groups,
+           (double) (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9, export_filepath);
+
+    if (is_compacting && num_of_groups == size) {
+        printf("\nEvery region name occurs once, the file was not changed");
+    } else if (is_compacting && is_saved) {
+        printf("\nRemoved " GREEN_BG BLACK_TEXT "%i" BLACK_BG GREEN_TEXT " duplicate records, "
+               "the last record of every region name was kept", size - num_of_groups);
+    } else if (is_compacting) {
+        printf("\nError:" ITALIC_TEXT " Can't compact the file %s"
+               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, working_file_name);
+    }
+
+    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
+           "close the program or any other button to return to the menu");
+
+    free(groups);
+    free_records_arr(data, size);
+
+    return working_file;
+}
+
+cached_file *get_cached_file(const char *file_name) {
+    cached_file *file = NULL;
+
+    if (strlen(file_name) >= FILENAME_SIZE || file_name[0] == '.' || strchr(file_name, '/') != NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&record_server.cache_mutex);
+
+    for (int i = 0; i < record_server.files_size; i++) {
+        if (strcmp(record_server.files[i]->name, file_name) == 0) {
+            file = record_server.files[i];
+            break;
+        }
+    }
+
+    char filepath[PATH_SIZE];
+    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, file_name);
+
+    if (file == NULL && file_exists(filepath)) {
+        if (record_server.files_size >= record_server.files_capacity) {
+            int capacity = record_server.files_capacity ? record_server.files_capacity * 2 : 8;
+            cached_file **files = (cached_file **) realloc(record_server.files, capacity * sizeof(cached_file *));
+
+            if (files == NULL) {
+                pthread_mutex_unlock(&record_server.cache_mutex);
+                return NULL;
+            }
+
+            record_server.files = files;
+            record_server.files_capacity = capacity;
+        }
+
+        file = (cached_file *) calloc(1, sizeof(cached_file));
+
+        if (file != NULL) {
+            strcpy(file->name, file_name);
+            pthread_mutex_init(&file->mutex, NULL);
+            file->log.fd = -1;
+            file->file = fopen(filepath, "a+");
+
+            if (file->file != NULL) {
+                working_log = &file->log;
+                file->file = open_working_log(file->file, file->name);
+                record_server.files[record_server.files_size++] = file;
+            } else {
+                pthread_mutex_destroy(&file->mutex);
+                free(file);
+                file = NULL;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&record_server.cache_mutex);
+
+    return file;
+}
+
+bool load_cached_file(cached_file *file) {
+    if (file->file == NULL || !file_exists(file->log.data_path)) {
+        return false;
+    }
+
+    lock_working_log(LOCK_SH);
+
+    if (file->data == NULL || refresh_working_log(file->file)) {
+        free_records_arr(file->data, file->size);
+        file->size = 0;
+        file->data = read_records_arr(file->file, &file->size);
     }
 
-    system("clear");
-    filenames = get_filenames_arr(working_folder, &num_of_files);
-    show_files(NOT_INTERACTIVE, filenames, num_of_files);
+    unlock_working_log();
 
-    printf("\nFile with name "GREEN_BG BLACK_TEXT"%s.txt"BLACK_BG GREEN_TEXT
-           " was created successfully!", filename);
+    return file->data != NULL;
+}
 
-    if (fclose(file)) {
-        printf("\nError:" ITALIC_TEXT " Can't close the file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+void release_cached_files() {
+    for (int i = 0; i < record_server.files_size; i++) {
+        cached_file *file = record_server.files[i];
+
+        working_log = &file->log;
+        close_working_file(file->file, file->name);
+        free_records_arr(file->data, file->size);
+        pthread_mutex_destroy(&file->mutex);
+        free(file);
     }
 
-    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-           "close the program or any other button to return to the menu");
+    free(record_server.files);
+    record_server.files = NULL;
+    record_server.files_size = 0;
 }
 
-bool input_double(double *input) {
-    char end_of_input = ' ';
-    double value;
+void serve_list(FILE *output) {
+    int num_of_files = 0;
+    char **filenames = get_filenames_arr(&num_of_files);
 
-    fflush(stdin);
+    if (filenames == NULL) {
+        fprintf(output, "ERR can't open the directory\n");
+        return;
+    }
 
-    if (scanf("%lf%c", &value, &end_of_input) && end_of_input == '\n') {
-        *input = value;
-        return true;
-    } else {
-        printf("Error:" ITALIC_TEXT "Invalid input. Please try again.\n"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        return false;
+    fprintf(output, "OK %i\n", num_of_files);
+
+    for (int i = 0; i < num_of_files; i++) {
+        fprintf(output, "%s\n", filenames[i]);
     }
-}
 
-bool input_int(int *input) {
-    char end_of_input = ' ';
-    int value;
+    free_filenames_arr(filenames, num_of_files);
+}
 
-    fflush(stdin);
+void serve_query(FILE *output, cached_file *file, char **arguments, int count) {
+    record_filter filter = {"", area_min, area_max, population_min, population_max};
+    int matched = 0;
 
-    if (scanf("%i%c", &value, &end_of_input) && end_of_input == '\n') {
-        *input = value;
-        return true;
-    } else {
-        printf("Error:" ITALIC_TEXT "Invalid input. Please try again.\n"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        return false;
+    if (count != 0 && count != 5) {
+        fprintf(output, "ERR usage: QUERY <file> [<prefix|*> <min area> <max area> <min population> <max population>]\n");
+        return;
     }
-}
 
-bool is_correct_area(const double *area, double min, double max) {
-    if (*area > max) {
-        printf("Error:" ITALIC_TEXT " Too large area. Area can't be larger than %lf"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, max);
-        return false;
+    if (count == 5) {
+        if (strcmp(arguments[0], "*") != 0) {
+            snprintf(filter.name_prefix, sizeof(filter.name_prefix), "%s", arguments[0]);
+        }
+
+        if (!parse_double(arguments[1], &filter.min_area) || !parse_double(arguments[2], &filter.max_area) ||
+            !parse_int(arguments[3], &filter.min_population) || !parse_int(arguments[4], &filter.max_population)) {
+            fprintf(output, "ERR invalid filter\n");
+            return;
+        }
     }
-    if (*area < min) {
-        printf("Error:" ITALIC_TEXT " Too small area. Area can't be smaller than %lf"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, min);
-        return false;
+
+    for (int i = 0; i < file->size; i++) {
+        matched += matches_filter(file->data[i], &filter);
     }
 
-    return true;
+    fprintf(output, "OK %i\n", matched);
+
+    for (int i = 0; i < file->size; i++) {
+        if (matches_filter(file->data[i], &filter)) {
+            write_record(output, file->data[i]);
+        }
+    }
 }
 
-void write_record(FILE *file, record *data) {
+void serve_insert(FILE *output, cached_file *file, char **arguments, int count) {
+    sort_keys keys;
+    enum wal_operation operation = WAL_APPEND;
+    enum record_status status;
+    record new_record;
+    bool is_saved;
 
-    if (file == NULL) {
-        printf("\nError:" ITALIC_TEXT " file was not found"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+    if (count != 3) {
+        fprintf(output, "ERR usage: INSERT <file> <name> <area> <population>\n");
         return;
     }
 
-    fprintf(file, "%s %lf %i\n",
-            data->region_name, data->region_area, data->region_population);
+    if (strlen(arguments[0]) >= REGION_NAME_MAX) {
+        fprintf(output, "ERR %s\n", record_status_names[RECORD_BAD_NAME]);
+        return;
+    }
 
-    fflush(file);
-}
+    strcpy(new_record.region_name, arguments[0]);
 
-bool is_correct_population(const int *population, double min, double max) {
-    if (*population > max) {
-        printf("Error:" ITALIC_TEXT " Too large population. Population can't be larger than %lf"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, max);
-        return false;
-    }
-    if (*population < min) {
-        printf("Error:" ITALIC_TEXT " Too small population. Population can't be smaller than %lf"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, min);
-        return false;
+    if (!parse_double(arguments[1], &new_record.region_area)) {
+        status = RECORD_BAD_AREA;
+    } else if (!parse_int(arguments[2], &new_record.region_population)) {
+        status = RECORD_BAD_POPULATION;
+    } else {
+        status = validate_record(&new_record);
     }
 
-    return true;
-}
+    if (status != RECORD_OK) {
+        fprintf(output, "ERR %s\n", record_status_names[status]);
+        return;
+    }
 
-bool file_exists(const char *filepath) {
-    return !access(filepath, F_OK);
-}
+    int position = file->size;
 
-char key_pressed() {
-    char answer;
+    if (file->size > 0 && check_sort_order(file->data, file->size, &keys)) {
+        operation = WAL_INSERT;
+        position = find_insert_position_by_keys((const record **) file->data, file->size, &new_record, &keys);
+    }
 
-    set_keypress();
-    answer = (char) getchar();
-    reset_keypress();
+    file->file = save_record_change(file->file, file->name, &file->data, &file->size,
+                                    operation, position, NULL, &new_record, &is_saved);
 
-    return answer;
+    if (is_saved) {
+        fprintf(output, "OK %i\n", position + 1);
+    } else {
+        fprintf(output, "ERR file was changed, try again\n");
+    }
 }
 
-bool string_input(char *line, int max_len) {
-    int i = 0;
-    char symbol_to_input;
+void serve_delete(FILE *output, cached_file *file, char **arguments, int count) {
+    int position;
+    bool is_saved;
 
-    do {
-        symbol_to_input = (char) getchar();
+    if (count != 1 || !parse_int(arguments[0], &position)) {
+        fprintf(output, "ERR usage: DELETE <file> <record number>\n");
+        return;
+    }
 
-        if (symbol_to_input == '\n') {
-            break;
-        }
+    if (position < 1 || position > file->size) {
+        fprintf(output, "ERR record number must be in [1; %i]\n", file->size);
+        return;
+    }
 
-        line[i] = symbol_to_input;
-        i++;
+    record old_record = *file->data[position - 1];
 
-    } while (i < max_len);
+    file->file = save_record_change(file->file, file->name, &file->data, &file->size,
+                                    WAL_DELETE, position - 1, &old_record, NULL, &is_saved);
 
-    if (symbol_to_input != '\n') {
-        printf("\nError:" ITALIC_TEXT " Input exceeds the maximum length "
-               "of %i characters. Please try again\n"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT, max_len - 1);
-        fflush(stdin);
-        return false;
+    if (is_saved) {
+        fprintf(output, "OK ");
+        write_record(output, &old_record);
+    } else {
+        fprintf(output, "ERR file was changed, try again\n");
     }
+}
 
-    line[i] = '\0';
+void serve_sort(FILE *output, cached_file *file, char **arguments, int count) {
+    sort_keys keys = {0};
+    bool is_valid = count >= 2 && count % 2 == 0;
 
-    return true;
-}
+    for (int i = 0; i + 1 < count && is_valid; i += 2) {
+        int sort_option = 0, order_option = 0;
 
-bool is_valid_filename(const char *filename) {
-    if (filename == NULL || strlen(filename) == 0) {
-        printf("\nEmpty input. Please try again\n");
-        return false;
-    }
+        while (sort_option < NUMBER_OF_SORTS && strcmp(arguments[i], sort_option_names[sort_option]) != 0) {
+            sort_option++;
+        }
 
-    const char *invalid_chars = "\\/:*?\"<>|";
-    size_t filename_len = strlen(filename);
+        while (order_option < NUMBER_OF_ORDERS &&
+               strncmp(arguments[i + 1], order_option_names[order_option], strlen(arguments[i + 1])) != 0) {
+            order_option++;
+        }
 
-    if (filename[0] == '.') {
-        printf("\nInvalid filename! Filename cannot start with '.'");
-        return false;
+        is_valid = sort_option < NUMBER_OF_SORTS && order_option < NUMBER_OF_ORDERS &&
+                   add_sort_key(&keys, sort_option, order_option);
     }
 
-    for (size_t i = 0; i < filename_len; i++) {
-        for (int j = 0; j < strlen(invalid_chars); j++) {
-            if (filename[i] == invalid_chars[j]) {
-                printf("\nInvalid filename! Found '%c' at position %zu."
-                       "\nDon't use symbols '%s'. Please try again",
-                       invalid_chars[j], i + 1, invalid_chars);
-                return false;
-            }
-        }
+    if (!is_valid) {
+        fprintf(output, "ERR usage: SORT <file> <name|area|population> <asc|desc> [<key> <asc|desc> ...]\n");
+        return;
     }
 
-    if (filename[filename_len - 1] == ' ') {
-        printf("\nInvalid filename! Filename cannot end with a space. Please try again");
-        return false;
+    uint64_t checkpoints = working_log->checkpoints;
+
+    resort_records(file->name, file->data, file->size, &keys);
+    file->file = checkpoint_working_file(file->file, file->name, file->data, file->size);
+
+    if (working_log->checkpoints != checkpoints) {
+        save_sorted_prefix(file->name, &working_log->header, &keys, file->size);
     }
 
-    return true;
+    fprintf(output, "OK %i\n", file->size);
 }
 
-record **get_records_arr(FILE *working_file, int *size) {
-    int capacity = 2, index = 0;
+void handle_request(FILE *output, char *line) {
+    char *fields[REQUEST_FIELDS_MAX];
+    int count = split_fields(line, ' ', fields, REQUEST_FIELDS_MAX);
 
-    if (working_file == NULL) {
-        printf("Error:" ITALIC_TEXT " No file was opened" RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        return NULL;
+    if (count == 0) {
+        return;
     }
 
-    fseek(working_file, 0, SEEK_SET);
+    for (char *cursor = fields[0]; *cursor != '\0'; cursor++) {
+        *cursor = (char) toupper((unsigned char) *cursor);
+    }
 
-    record **data = (record **) malloc(capacity * sizeof(record *));
+    if (strcmp(fields[0], "LIST") == 0) {
+        serve_list(output);
+        return;
+    }
 
-    if (data == NULL) {
-        printf("Error:" ITALIC_TEXT " Memory allocation failed" RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        return NULL;
+    if (strcmp(fields[0], "QUERY") != 0 && strcmp(fields[0], "INSERT") != 0 &&
+        strcmp(fields[0], "DELETE") != 0 && strcmp(fields[0], "SORT") != 0) {
+        fprintf(output, "ERR unknown request %s\n", fields[0]);
+        return;
     }
 
-    char region_name[REGION_NAME_MAX] = "";
-    double region_area = 0;
-    int region_population = 0;
+    if (count < 2 || count > REQUEST_FIELDS_MAX) {
+        fprintf(output, "ERR wrong number of arguments\n");
+        return;
+    }
 
-    while (fscanf(working_file, "%s %lf %i", region_name, &region_area, &region_population) != EOF) {
-        if (index >= capacity) {
-            capacity *= 2;
-            data = (record **) realloc(data, capacity * sizeof(record *));
+    cached_file *file = get_cached_file(fields[1]);
 
-            if (data == NULL) {
-                printf("Error:" ITALIC_TEXT " Memory reallocation failed" RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-                return NULL;
-            }
-        }
+    if (file == NULL) {
+        fprintf(output, "ERR file %s was not found\n", fields[1]);
+        return;
+    }
 
-        data[index] = (record *) malloc(sizeof(record));
+    pthread_mutex_lock(&file->mutex);
+    working_log = &file->log;
+    lock_working_log(strcmp(fields[0], "QUERY") == 0 ? LOCK_SH : LOCK_EX);
+
+    if (!load_cached_file(file)) {
+        fprintf(output, "ERR can't read file %s\n", fields[1]);
+    } else if (strcmp(fields[0], "QUERY") == 0) {
+        serve_query(output, file, fields + 2, count - 2);
+    } else if (strcmp(fields[0], "INSERT") == 0) {
+        serve_insert(output, file, fields + 2, count - 2);
+    } else if (strcmp(fields[0], "DELETE") == 0) {
+        serve_delete(output, file, fields + 2, count - 2);
+    } else {
+        serve_sort(output, file, fields + 2, count - 2);
+    }
 
-        if (data[index] == NULL) {
-            printf("Error:" ITALIC_TEXT " Memory allocation failed" RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-            return NULL;
-        }
+    unlock_working_log();
 
-        strncpy(data[index]->region_name, region_name, REGION_NAME_MAX - 1);
-        data[index]->region_name[REGION_NAME_MAX - 1] = '\0';
+    if (file->file != NULL) {
+        file->file = flush_working_log(file->file, file->name, WAL_CHECKPOINT_SIZE);
+        commit_working_log();
+    }
 
-        data[index]->region_area = region_area;
-        data[index]->region_population = region_population;
+    pthread_mutex_unlock(&file->mutex);
+}
 
-        index++;
+void free_connection(server_connection *connection) {
+    if (connection->output != NULL) {
+        fclose(connection->output);
     }
 
-    *size = index;
-
-    return data;
+    close(connection->fd);
+    pthread_mutex_destroy(&connection->mutex);
+    free(connection->input);
+    free(connection);
 }
 
-char **get_filenames_arr(const char *folder, int *num_of_files) {
-    int capacity = 2, index = 0;
-    DIR *dir;
-    struct dirent *entry;
+void enqueue_connection(server_connection *connection) {
+    pthread_mutex_lock(&record_server.queue_mutex);
 
-    dir = opendir(folder);
+    connection->next = NULL;
 
-    if (dir == NULL) {
-        printf("Error:" ITALIC_TEXT " Cant open the directory"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        return NULL;
+    if (record_server.queue_tail != NULL) {
+        record_server.queue_tail->next = connection;
+    } else {
+        record_server.queue_head = connection;
     }
 
-    char **files = (char **) malloc(capacity * sizeof(char *));
+    record_server.queue_tail = connection;
 
-    if (files == NULL) {
-        printf("Error:" ITALIC_TEXT " Memory allocation failed"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        return NULL;
-    }
+    pthread_cond_signal(&record_server.queue_ready);
+    pthread_mutex_unlock(&record_server.queue_mutex);
+}
 
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_name[0] == '.') {
-            continue;
-        }
+server_connection *dequeue_connection() {
+    server_connection *connection;
 
-        if (index >= capacity) {
-            capacity *= 2;
-            files = (char **) realloc(files, capacity * sizeof(char *));
+    pthread_mutex_lock(&record_server.queue_mutex);
 
-            if (files == NULL) {
-                printf("Error:" ITALIC_TEXT " Memory reallocation failed"
-                       RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-                return NULL;
-            }
-        }
+    while (record_server.queue_head == NULL && !record_server.is_stopped) {
+        pthread_cond_wait(&record_server.queue_ready, &record_server.queue_mutex);
+    }
 
-        files[index] = strdup(entry->d_name);
+    connection = record_server.queue_head;
 
-        if (files[index] == NULL) {
-            printf("Error:" ITALIC_TEXT " Memory allocation failed"
-                   RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-            return NULL;
-        }
+    if (connection != NULL) {
+        record_server.queue_head = connection->next;
 
-        index++;
+        if (record_server.queue_head == NULL) {
+            record_server.queue_tail = NULL;
+        }
     }
 
-    closedir(dir);
-    *num_of_files = index;
+    pthread_mutex_unlock(&record_server.queue_mutex);
 
-    return files;
+    return connection;
 }
 
-FILE *open_file(FILE *opened_file, char **file_name) {
-    int num_of_files, current_position = 0;
-    bool is_chosen = false, is_exit = false;
-    FILE *file = NULL;
+void process_connection(server_connection *connection) {
+    while (true) {
+        pthread_mutex_lock(&connection->mutex);
 
-    char **filenames = get_filenames_arr(working_folder, &num_of_files);
+        char *line_end = (char *) memchr(connection->input, '\n', connection->input_size);
 
-    if (num_of_files == 0) {
-        system("clear");
-        printf("Error:" ITALIC_TEXT " Empty folder"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return NULL;
-    }
+        if (line_end == NULL) {
+            bool is_finished = connection->is_closed;
 
-    do {
-        system("clear");
-        show_files(current_position, filenames, num_of_files);
-        current_position = navigate_list(current_position, num_of_files, &is_exit, &is_chosen);
+            fflush(connection->output);
+            connection->is_busy = false;
+            pthread_mutex_unlock(&connection->mutex);
 
-        if (is_exit) {
-            break;
+            if (is_finished) {
+                free_connection(connection);
+            }
+            return;
         }
 
-    } while (!is_chosen);
-
-    if (is_exit) {
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return NULL;
-    }
-
-    if (opened_file != NULL) {
-        fclose(opened_file);
-    }
+        size_t length = line_end - connection->input;
+        char *line = strndup(connection->input, length);
 
-    char filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, filenames[current_position]);
+        connection->input_size -= length + 1;
+        memmove(connection->input, line_end + 1, connection->input_size);
 
-    if (file_exists(filepath)) {
+        pthread_mutex_unlock(&connection->mutex);
 
-        file = fopen(filepath, "a+");
+        if (line == NULL) {
+            fprintf(connection->output, "ERR memory allocation failed\n");
+            continue;
+        }
 
-        if (file == NULL) {
-            printf("\nError:" ITALIC_TEXT " Can't open the file for writing"
-                   RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-            return NULL;
+        if (length > 0 && line[length - 1] == '\r') {
+            line[length - 1] = '\0';
         }
 
+        handle_request(connection->output, line);
+        free(line);
     }
+}
 
-    printf("File %s opened successfully!\n", filenames[current_position]);
-    *file_name = strdup(filenames[current_position]);
+void *server_worker(void *argument) {
+    server_connection *connection;
 
-    free_filenames_arr(filenames, num_of_files);
+    (void) argument;
 
-    return file;
+    while ((connection = dequeue_connection()) != NULL) {
+        uint64_t span = begin_span();
+
+        process_connection(connection);
+        end_span("process_connection", span);
+    }
+
+    return NULL;
 }
 
-FILE *delete_file(FILE *working_file) {
-    int num_of_files, current_position = 0;
-    char **filenames = get_filenames_arr(working_folder, &num_of_files);
-    bool is_chosen = false, is_exit = false;
+void stop_server(int signal_number) {
+    (void) signal_number;
+    record_server.is_stopped = true;
+}
 
+void accept_connection(int listen_fd) {
+    int fd = accept(listen_fd, NULL, NULL);
 
-    if (num_of_files == 0) {
-        system("clear");
-        printf("Error:" ITALIC_TEXT " Empty folder"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return NULL;
+    if (fd == -1) {
+        return;
     }
 
-    do {
-        system("clear");
-        show_files(current_position, filenames, num_of_files);
-        current_position = navigate_list(current_position, num_of_files, &is_exit, &is_chosen);
+    server_connection *connection = (server_connection *) calloc(1, sizeof(server_connection));
+    int output_fd = dup(fd);
 
-        if (is_exit) {
-            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-                   "close the program or any other button to return to the menu");
-            return NULL;
+    if (connection == NULL || output_fd == -1 ||
+        (connection->output = fdopen(output_fd, "w")) == NULL) {
+        if (output_fd != -1) {
+            close(output_fd);
         }
+        free(connection);
+        close(fd);
+        return;
+    }
 
-    } while (!is_chosen);
+    connection->fd = fd;
+    pthread_mutex_init(&connection->mutex, NULL);
 
-    if (is_exit) {
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = connection};
+
+    if (epoll_ctl(record_server.epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        free_connection(connection);
     }
+}
 
-    char filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, filenames[current_position]);
+void read_connection(server_connection *connection) {
+    bool is_queued = false, is_freed = false;
+    ssize_t bytes_read = -1;
 
-    char *deleted_file_name;
+    pthread_mutex_lock(&connection->mutex);
 
-    if (file_exists(filepath)) {
-        if (!remove(filepath)) {
+    if (connection->input_size == connection->input_capacity &&
+        connection->input_capacity < SERVER_INPUT_MAX) {
+        size_t capacity = connection->input_capacity ? connection->input_capacity * 2 : SERVER_INPUT_SIZE;
+        char *input = (char *) realloc(connection->input, capacity);
 
-            deleted_file_name = filenames[current_position];
-            filenames = get_filenames_arr(working_folder, &num_of_files);
+        if (input != NULL) {
+            connection->input = input;
+            connection->input_capacity = capacity;
+        }
+    }
 
-            system("clear");
-            show_files(current_position, filenames, num_of_files);
+    if (connection->input_size < connection->input_capacity) {
+        bytes_read = read(connection->fd, connection->input + connection->input_size,
+                          connection->input_capacity - connection->input_size);
+    }
 
-            printf("\nFile "GREEN_BG BLACK_TEXT"%s"BLACK_BG GREEN_TEXT
-                   " has been deleted successfully", deleted_file_name);
-            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-                   "close the program or any other button to return to the menu");
-            return NULL;
-        } else {
-            printf("\nError:" ITALIC_TEXT " Can't delete the file"
-                   RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        }
+    if (bytes_read <= 0) {
+        epoll_ctl(record_server.epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+        connection->is_closed = true;
+        is_freed = !connection->is_busy;
     } else {
-        printf("\nError:" ITALIC_TEXT " File was not found"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+        connection->input_size += bytes_read;
+
+        if (!connection->is_busy && memchr(connection->input, '\n', connection->input_size) != NULL) {
+            connection->is_busy = true;
+            is_queued = true;
+        }
     }
 
-    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-           "close the program or any other button to return to the menu");
+    pthread_mutex_unlock(&connection->mutex);
 
-    return working_file;
+    if (is_queued) {
+        enqueue_connection(connection);
+    } else if (is_freed) {
+        free_connection(connection);
+    }
 }
 
-void create_record(FILE *working_file, char *working_file_name) {
-    int size = 0;
-    record input_data;
-    record **data;
+bool get_server_address(struct sockaddr_un *address) {
+    memset(address, 0, sizeof(struct sockaddr_un));
+    address->sun_family = AF_UNIX;
 
-    if (working_file == NULL) {
-        system("clear");
-        printf("Error:" ITALIC_TEXT " No file was opened"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return;
-    }
+    return snprintf(address->sun_path, sizeof(address->sun_path), "%s/%s",
+                    working_folder, server_socket_name) < (int) sizeof(address->sun_path);
+}
 
-    do {
-        system("clear");
+int run_server() {
+    struct sockaddr_un address;
+    struct epoll_event events[SERVER_EVENTS_MAX];
+    struct sigaction action = {.sa_handler = stop_server};
+    pthread_t workers[SERVER_THREADS_MAX];
 
-        data = get_records_arr(working_file, &size);
-        show_records(NOT_INTERACTIVE, working_file_name, size, data);
+    create_working_folder(working_folder);
 
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
 
-        do {
-            printf("\nEnter name of region (max %i characters): ", REGION_NAME_MAX - 1);
-        } while (!string_input(input_data.region_name, REGION_NAME_MAX));
+    if (listen_fd == -1 || !get_server_address(&address)) {
+        perror("socket");
+        return 1;
+    }
 
-        do {
-            printf("\nEnter size of region area [%.0lf; %.0lf]: ", area_min, area_max);
-        } while (!input_double(&input_data.region_area) ||
-                 !is_correct_area(&input_data.region_area, area_min, area_max));
+    unlink(address.sun_path);
 
-        do {
-            printf("\nEnter population of region [%i; %i]: ", population_min, population_max);
-        } while (!input_int(&input_data.region_population) ||
-                 !is_correct_population(&input_data.region_population, population_min, population_max));
+    if (bind(listen_fd, (struct sockaddr *) &address, sizeof(address)) == -1 ||
+        listen(listen_fd, SOMAXCONN) == -1) {
+        perror("bind");
+        close(listen_fd);
+        return 1;
+    }
 
-        write_record(working_file, &input_data);
+    record_server.epoll_fd = epoll_create1(0);
 
-        printf("\nRecord was saved successfully!");
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to stop input "
-               "\nor any other button to continue input records\n");
+    struct epoll_event listen_event = {.events = EPOLLIN, .data.ptr = NULL};
 
-    } while (key_pressed() != EXIT_BUTTON);
+    if (record_server.epoll_fd == -1 ||
+        epoll_ctl(record_server.epoll_fd, EPOLL_CTL_ADD, listen_fd, &listen_event) == -1) {
+        perror("epoll");
+        close(listen_fd);
+        unlink(address.sun_path);
+        return 1;
+    }
 
-    data = get_records_arr(working_file, &size);
-    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
 
-    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-           "close the program or any other button to return to the menu");
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_of_workers = threads < 1 ? 1 : threads > SERVER_THREADS_MAX ? SERVER_THREADS_MAX : (int) threads;
+    int started = 0;
 
-}
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
 
-void show_records(int current_position, char *working_file_name, int size, record **data) {
+    while (started < num_of_workers && pthread_create(&workers[started], NULL, server_worker, NULL) == 0) {
+        started++;
+    }
 
-    system("clear");
+    pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
 
-    if (size == 0) {
-        printf("File %s is empty\n", working_file_name);
-        return;
+    if (started == 0) {
+        printf("Error: can't start worker threads\n");
+        close(record_server.epoll_fd);
+        close(listen_fd);
+        unlink(address.sun_path);
+        return 1;
     }
 
-    printf("Records in file %s\n\n", working_file_name);
-    printf("%-5s%-30s%-20s%-20s\n", "No.", "REGION NAME", "AREA SIZE", "POPULATION");
-    for (int i = 0; i < size; i++) {
-        printf("%s%-5d%-30s%-20.2lf%-20i%s\n",
-               (current_position == i) ? GREEN_BG BLACK_TEXT : "",
-               i + 1,
-               data[i]->region_name,
-               data[i]->region_area,
-               data[i]->region_population,
-               (current_position == i) ? BLACK_BG GREEN_TEXT : "");
-    }
-}
+    printf("Serving %s on %s with %i worker threads, press Ctrl+C to stop\n",
+           working_folder, address.sun_path, started);
+    fflush(stdout);
 
-void read_record(FILE *working_file, char *working_file_name) {
-    int size = 0;
+    while (!record_server.is_stopped) {
+        int count = epoll_wait(record_server.epoll_fd, events, SERVER_EVENTS_MAX, -1);
 
-    if (working_file == NULL) {
-        system("clear");
-        printf("Error:" ITALIC_TEXT " No file was opened"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return;
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.ptr == NULL) {
+                accept_connection(listen_fd);
+            } else {
+                read_connection((server_connection *) events[i].data.ptr);
+            }
+        }
     }
 
-    record **data = get_records_arr(working_file, &size);
+    pthread_mutex_lock(&record_server.queue_mutex);
+    pthread_cond_broadcast(&record_server.queue_ready);
+    pthread_mutex_unlock(&record_server.queue_mutex);
 
-    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
 
-    free_records_arr(data, size);
+    release_cached_files();
 
-    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-           "close the program or any other button to return to the menu");
-}
+    close(record_server.epoll_fd);
+    close(listen_fd);
+    unlink(address.sun_path);
 
-FILE *delete_record(FILE *working_file, char *working_file_name) {
-    int size = 0, current_position = 0;
-    bool is_chosen = false, is_exit = false;
+    printf("\nServer stopped\n");
 
+    return 0;
+}
 
-    if (working_file == NULL) {
-        system("clear");
-        printf("Error:" ITALIC_TEXT " No file was opened"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
-    }
+bool write_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t bytes_written = write(fd, data, size);
 
-    record **data = get_records_arr(working_file, &size);
+        if (bytes_written == -1 && errno == EINTR) {
+            continue;
+        }
 
-    if (size == 0) {
-        system("clear");
+        if (bytes_written <= 0) {
+            return false;
+        }
 
-        printf("Error:" ITALIC_TEXT " Empty file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+        data += bytes_written;
+        size -= bytes_written;
     }
 
-    do {
-        system("clear");
-        show_records(current_position, working_file_name, size, data);
-        current_position = navigate_list(current_position, size, &is_exit, &is_chosen);
+    return true;
+}
 
-        if (is_exit) {
-            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-                   "close the program or any other button to return to the menu");
-            return working_file;
-        }
-    } while (!is_chosen);
+int run_client() {
+    struct sockaddr_un address;
+    bool is_input_open = true;
 
-    if (is_exit) {
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
-    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
 
-    char temp_filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(temp_filepath, sizeof(temp_filepath), "%s/%s", working_folder, "temp.txt");
+    if (fd == -1 || !get_server_address(&address) ||
+        connect(fd, (struct sockaddr *) &address, sizeof(address)) == -1) {
+        perror("connect");
+        return 1;
+    }
 
-    FILE *temp_file = fopen(temp_filepath, "w");
+    char *buffer = (char *) malloc(READ_BUFFER_SIZE);
 
-    if (temp_file == NULL) {
-        printf("Error:" ITALIC_TEXT " Can't create temporary file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+    if (buffer == NULL) {
+        close(fd);
+        return 1;
     }
 
-    record temp_data;
+    struct pollfd fds[2] = {{.fd = STDIN_FILENO, .events = POLLIN},
+                            {.fd = fd, .events = POLLIN}};
 
-    for (int i = 0; i < size; i++) {
-        if (i == current_position) {
-            strcpy(temp_data.region_name, data[i]->region_name);
-            temp_data.region_area = data[i]->region_area;
-            temp_data.region_population = data[i]->region_population;
-            continue;
+    while (true) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
         }
-        write_record(temp_file, data[i]);
-    }
 
-    fclose(working_file);
-    fclose(temp_file);
+        if (is_input_open && fds[0].revents != 0) {
+            ssize_t bytes_read = read(STDIN_FILENO, buffer, READ_BUFFER_SIZE);
 
-    char filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, working_file_name);
+            if (bytes_read <= 0 || !write_all(fd, buffer, bytes_read)) {
+                shutdown(fd, SHUT_WR);
+                is_input_open = false;
+                fds[0].fd = -1;
+            }
+        }
 
-    if (rename(temp_filepath, filepath) != 0) {
-        printf("Error:" ITALIC_TEXT " Can't rename temporary file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+        if (fds[1].revents != 0) {
+            ssize_t bytes_read = read(fd, buffer, READ_BUFFER_SIZE);
+
+            if (bytes_read <= 0 || !write_all(STDOUT_FILENO, buffer, bytes_read)) {
+                break;
+            }
+        }
     }
 
-    working_file = fopen(filepath, "a+");
+    free(buffer);
+    close(fd);
 
-    system("clear");
+    return 0;
+}
 
-    data = get_records_arr(working_file, &size);
-    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+uint64_t next_generator_random(uint64_t *state) {
+    uint64_t value = (*state += 0x9E3779B97F4A7C15ULL);
 
-    printf("\nRecord №%i [%s %lf %i] was deleted successfully!",
-           current_position + 1, temp_data.region_name,
-           temp_data.region_area, temp_data.region_population);
-    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-           "close the program or any other button to return to the menu");
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
 
-    free_records_arr(data, size);
+    return value ^ (value >> 31);
+}
 
-    return working_file;
+long get_zipf_rank(uint64_t *state, long vocabulary) {
+    double uniform = (double) (next_generator_random(state) >> 11) / (double) (1ULL << 53);
+    long rank = (long) exp(uniform * log((double) vocabulary + 1)) - 1;
+
+    return rank < vocabulary ? rank : vocabulary - 1;
 }
 
-FILE *edit_record(FILE *working_file, char *working_file_name) {
-    int size = 0, current_position = 0;
-    bool is_chosen = false, is_exit = false;
+void make_region_name(char *name, uint64_t key, int length, long ordered_index, int ordered_width) {
+    uint64_t state = key;
+    int position = 0;
 
+    if (ordered_index >= 0) {
+        for (int i = ordered_width - 1; i >= 0; i--) {
+            name[i] = (char) ('a' + ordered_index % 26);
+            ordered_index /= 26;
+        }
+        position = ordered_width;
+    } else {
+        name[position++] = (char) ('A' + next_generator_random(&state) % 26);
+    }
 
-    if (working_file == NULL) {
-        system("clear");
-        printf("Error:" ITALIC_TEXT " No file was opened"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+    while (position < length) {
+        name[position++] = (char) ('a' + next_generator_random(&state) % 26);
     }
 
-    record **data = get_records_arr(working_file, &size);
+    name[position] = '\0';
+}
 
-    if (size == 0) {
-        system("clear");
+void generate_record(record_generator *generator, long row, uint64_t *state, record *data) {
+    int length_range = generator->max_name_length - generator->min_name_length + 1;
+    int name_length = generator->min_name_length + (int) (next_generator_random(state) % length_range);
+    double fraction = generator->rows > 1 ? (double) row / (double) (generator->rows - 1) : 0;
+    long key;
+
+    switch (generator->distribution) {
+        case ZIPF_DISTRIBUTION:
+            key = get_zipf_rank(state, GENERATOR_VOCABULARY);
+            make_region_name(data->region_name, (uint64_t) key, name_length, -1, 0);
+            data->region_area = area_max * (double) get_zipf_rank(state, GENERATOR_VOCABULARY) / GENERATOR_VOCABULARY;
+            data->region_population = (int) ((double) population_max *
+                                             get_zipf_rank(state, GENERATOR_VOCABULARY) / GENERATOR_VOCABULARY);
+            break;
+        case SORTED_DISTRIBUTION:
+        case REVERSE_DISTRIBUTION:
+            if (generator->distribution == REVERSE_DISTRIBUTION) {
+                row = generator->rows - 1 - row;
+                fraction = 1 - fraction;
+            }
 
-        printf("Error:" ITALIC_TEXT " Empty file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+            make_region_name(data->region_name, (uint64_t) row,
+                             name_length > generator->ordered_width ? name_length : generator->ordered_width,
+                             row, generator->ordered_width);
+            data->region_area = round(area_min + (area_max - area_min) * fraction);
+            data->region_population = (int) (population_min + (double) (population_max - population_min) * fraction);
+            break;
+        case DUPLICATES_DISTRIBUTION:
+            key = (long) (next_generator_random(state) % GENERATOR_DUPLICATES);
+            *state = (uint64_t) key;
+            name_length = generator->min_name_length + (int) (next_generator_random(state) % length_range);
+            make_region_name(data->region_name, (uint64_t) key, name_length, -1, 0);
+            data->region_area = (double) (next_generator_random(state) % 1000000) * area_max / 1000000;
+            data->region_population = (int) (next_generator_random(state) % ((uint64_t) population_max + 1));
+            break;
+        default:
+            make_region_name(data->region_name, next_generator_random(state), name_length, -1, 0);
+            data->region_area = (double) (next_generator_random(state) % ((uint64_t) area_max * 1000 + 1)) / 1000;
+            data->region_population = (int) (next_generator_random(state) % ((uint64_t) population_max + 1));
+            break;
     }
+}
 
-    do {
-        system("clear");
-        show_records(current_position, working_file_name, size, data);
-        current_position = navigate_list(current_position, size, &is_exit, &is_chosen);
+void *generator_worker(void *argument) {
+    record_generator *generator = (record_generator *) argument;
+    write_buffer buffer;
+    columnar_writer columnar = {0};
+    record data;
+
+    if (!init_write_buffer(&buffer, generator->file, GENERATOR_BLOCK_ROWS * 64 + RECORD_LINE_MAX) ||
+        (generator->format == COLUMNAR_FORMAT && !init_columnar_writer(&columnar, &buffer))) {
+        free_write_buffer(&buffer);
+        pthread_mutex_lock(&generator->mutex);
+        generator->is_failed = true;
+        pthread_cond_broadcast(&generator->turn);
+        pthread_mutex_unlock(&generator->mutex);
+        return NULL;
+    }
 
-        if (is_exit) {
-            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-                   "close the program or any other button to return to the menu");
-            return working_file;
-        }
-    } while (!is_chosen);
+    while (true) {
+        pthread_mutex_lock(&generator->mutex);
+        long block = generator->next_block++;
+        pthread_mutex_unlock(&generator->mutex);
 
-    if (is_exit) {
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
-    }
+        long first_row = block * GENERATOR_BLOCK_ROWS;
 
-    char temp_filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(temp_filepath, sizeof(temp_filepath), "%s/%s", working_folder, "temp.txt");
+        if (first_row >= generator->rows) {
+            break;
+        }
 
-    FILE *temp_file = fopen(temp_filepath, "w");
+        long last_row = first_row + GENERATOR_BLOCK_ROWS < generator->rows ? first_row + GENERATOR_BLOCK_ROWS
+                                                                           : generator->rows;
+        uint64_t block_state = generator->seed ^ ((uint64_t) block * 0xD1B54A32D192ED03ULL);
+        uint64_t state = next_generator_random(&block_state);
+        uint64_t span = begin_span();
+
+        for (long row = first_row; row < last_row; row++) {
+            generate_record(generator, row, &state, &data);
+
+            if (generator->format == COLUMNAR_FORMAT) {
+                add_columnar_record(&columnar, &data);
+            } else if (generator->format == BINARY_FORMAT) {
+                buffer_write_export(&buffer, &data, BINARY_FORMAT);
+            } else {
+                buffer_write_record(&buffer, &data);
+            }
 
-    if (temp_file == NULL) {
-        printf("Error:" ITALIC_TEXT " Can't create temporary file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
-    }
+            if (generator->distribution == DUPLICATES_DISTRIBUTION) {
+                state = next_generator_random(&block_state);
+            }
+        }
 
-    record input_data;
-    record temp_data;
+        flush_columnar_block(&columnar);
+        end_span("generate block", span);
+        span = begin_span();
 
-    for (int i = 0; i < size; i++) {
-        if (i == current_position) {
-            do {
-                printf("Enter name of region (max %i characters): ", REGION_NAME_MAX - 1);
-            } while (!string_input(input_data.region_name, REGION_NAME_MAX));
-
-            do {
-                printf("\nEnter size of region area [%.0lf; %.0lf]: ", area_min, area_max);
-            } while (!input_double(&input_data.region_area) ||
-                     !is_correct_area(&input_data.region_area, area_min, area_max));
-
-            do {
-                printf("\nEnter population of region [%i; %i]: ", population_min, population_max);
-            } while (!input_int(&input_data.region_population) ||
-                     !is_correct_population(&input_data.region_population,
-                                            population_min, population_max));
-
-            strcpy(temp_data.region_name, data[i]->region_name);
-            temp_data.region_area = data[i]->region_area;
-            temp_data.region_population = data[i]->region_population;
-
-            write_record(temp_file, &input_data);
-            continue;
+        pthread_mutex_lock(&generator->mutex);
+
+        while (generator->written_blocks != block && !generator->is_failed) {
+            pthread_cond_wait(&generator->turn, &generator->mutex);
         }
-        write_record(temp_file, data[i]);
-    }
 
-    fclose(working_file);
-    fclose(temp_file);
+        if (!generator->is_failed && !flush_write_buffer(&buffer)) {
+            generator->is_failed = true;
+        }
 
-    char filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, working_file_name);
+        buffer.size = 0;
+        generator->written_blocks++;
+        pthread_cond_broadcast(&generator->turn);
+        pthread_mutex_unlock(&generator->mutex);
 
-    if (rename(temp_filepath, filepath) != 0) {
-        printf("Error:" ITALIC_TEXT " Can't rename temporary file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+        end_span("write block", span);
     }
 
-    working_file = fopen(filepath, "a+");
+    free_columnar_writer(&columnar);
+    free_write_buffer(&buffer);
 
-    system("clear");
+    return NULL;
+}
 
-    data = get_records_arr(working_file, &size);
-    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+int run_generator(int argc, char *argv[]) {
+    record_generator generator = {.format = CSV_FORMAT, .distribution = UNIFORM_DISTRIBUTION,
+                                  .min_name_length = 4, .max_name_length = 12, .seed = 1,
+                                  .mutex = PTHREAD_MUTEX_INITIALIZER, .turn = PTHREAD_COND_INITIALIZER};
+    pthread_t workers[GENERATOR_THREADS_MAX];
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    struct timespec start, finish;
+    char *end;
+    bool is_valid = argc >= 4;
+
+    if (is_valid) {
+        generator.rows = strtol(argv[3], &end, 10);
+        is_valid = *end == '\0' && generator.rows > 0 && generator.rows <= INT_MAX;
+    }
 
-    printf("\nRecord №%i " ITALIC_TEXT "[%s %lf %i]"
-           RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT
-           " was replaced with record " ITALIC_TEXT "[%s %lf %i]"
-           RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT,
-           current_position + 1, temp_data.region_name,
-           temp_data.region_area, temp_data.region_population,
-           input_data.region_name, input_data.region_area, input_data.region_population);
-    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-           "close the program or any other button to return to the menu");
+    for (int i = 4; i + 1 < argc && is_valid; i += 2) {
+        if (strcmp(argv[i], "--format") == 0) {
+            generator.format = strcmp(argv[i + 1], "binary") == 0     ? BINARY_FORMAT
+                               : strcmp(argv[i + 1], "columnar") == 0 ? COLUMNAR_FORMAT
+                                                                      : CSV_FORMAT;
+            is_valid = generator.format != CSV_FORMAT || strcmp(argv[i + 1], "text") == 0;
+        } else if (strcmp(argv[i], "--distribution") == 0) {
+            generator.distribution = UNIFORM_DISTRIBUTION;
+
+            while (generator.distribution < NUMBER_OF_DISTRIBUTIONS &&
+                   strcmp(argv[i + 1], distribution_names[generator.distribution]) != 0) {
+                generator.distribution++;
+            }
 
-    free_records_arr(data, size);
+            is_valid = generator.distribution < NUMBER_OF_DISTRIBUTIONS;
+        } else if (strcmp(argv[i], "--name-length") == 0) {
+            is_valid = sscanf(argv[i + 1], "%i-%i", &generator.min_name_length, &generator.max_name_length) == 2 &&
+                       generator.min_name_length >= 1 && generator.min_name_length <= generator.max_name_length &&
+                       generator.max_name_length <= REGION_NAME_MAX - 1;
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            threads = strtol(argv[i + 1], &end, 10);
+            is_valid = *end == '\0' && threads >= 1;
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            generator.seed = strtoull(argv[i + 1], &end, 10);
+            is_valid = *end == '\0';
+        } else {
+            is_valid = false;
+        }
+    }
 
-    return working_file;
-}
+    if (!is_valid || (argc - 4) % 2 != 0) {
+        printf("Usage: %s --generate <path> <rows> [--format text|binary|columnar] "
+               "[--distribution uniform|zipf|sorted|reverse|duplicates] "
+               "[--name-length MIN-MAX] [--threads N] [--seed N]\n", argv[0]);
+        return 1;
+    }
 
-void show_sort_options(enum sort_option current_option) {
+    for (long rows = generator.rows - 1; rows > 0; rows /= 26) {
+        generator.ordered_width++;
+    }
 
-    printf("\nChoose how to sort\n");
+    if (generator.ordered_width == 0) {
+        generator.ordered_width = 1;
+    }
 
-    for (int i = 0; i < NUMBER_OF_SORTS; i++) {
-        printf("%s by %s%s\n",
-               (current_option == i) ? GREEN_BG BLACK_TEXT "-->" : "",
-               sort_option_names[i],
-               (current_option == i) ? BLACK_BG GREEN_TEXT : "");
+    if ((generator.distribution == SORTED_DISTRIBUTION || generator.distribution == REVERSE_DISTRIBUTION) &&
+        generator.ordered_width > REGION_NAME_MAX - 1) {
+        printf("Error: too many rows for ordered names\n");
+        return 1;
     }
-}
 
-void show_order_options(enum order_option current_option) {
+    generator.file = fopen(argv[2], "w");
 
-    printf("\nChoose in which order to sort\n");
+    if (generator.file == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
 
-    for (int i = 0; i < NUMBER_OF_ORDERS; i++) {
-        printf("%s in %s%s\n",
-               (current_option == i) ? GREEN_BG BLACK_TEXT "-->" : "",
-               order_option_names[i],
-               (current_option == i) ? BLACK_BG GREEN_TEXT : "");
+    if (generator.format == BINARY_FORMAT) {
+        fwrite(BINARY_MAGIC, 1, BINARY_MAGIC_SIZE, generator.file);
+    } else if (generator.format == COLUMNAR_FORMAT) {
+        fwrite(COLUMNAR_MAGIC, 1, COLUMNAR_MAGIC_SIZE, generator.file);
     }
-}
 
-void swap_records(record **record1, record **record2) {
-    record *temp = *record1;
-    *record1 = *record2;
-    *record2 = temp;
-}
+    int num_of_workers = threads > GENERATOR_THREADS_MAX ? GENERATOR_THREADS_MAX : (int) threads;
+    int started = 0;
 
-void sort_records(record **data, int size,
-                  enum sort_option sort_option,
-                  enum order_option order_option) {
-    for (int i = 0; i < size - 1; i++) {
-        for (int j = 0; j < size - i - 1; j++) {
-            int comparison_result = compare_records(data[j], data[j + 1], sort_option, order_option);
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
-            if (comparison_result > 0) {
-                swap_records(&data[j], &data[j + 1]);
-            }
-        }
+    while (started < num_of_workers && pthread_create(&workers[started], NULL, generator_worker, &generator) == 0) {
+        started++;
     }
-}
 
-bool is_sorted(record **data, int size, enum sort_option sort, enum order_option order) {
-    for (int i = 1; i < size; ++i) {
-        if (compare_records(data[i - 1], data[i], sort, order) > 0) {
-            return false;
-        }
+    if (started == 0) {
+        generator_worker(&generator);
     }
 
-    return true;
-}
-
-bool check_sort_order(record **data, int size,
-                      enum sort_option *found_sort_option,
-                      enum order_option *found_order_option) {
-    for (int sort = 0; sort < NUMBER_OF_SORTS; ++sort) {
-        for (int order = 0; order < NUMBER_OF_ORDERS; ++order) {
-            if (is_sorted(data, size, sort, order)) {
-                *found_sort_option = sort;
-                *found_order_option = order;
-                return true;
-            }
-        }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
     }
 
-    return false;
-}
+    num_of_workers = started > 0 ? started : 1;
 
-FILE *order_records(FILE *working_file, char *working_file_name) {
-    int size = 0;
-    bool is_chosen_sort = false, is_chosen_order = false, is_exit = false;
-    enum sort_option current_sort_option = NAME_SORT;
-    enum order_option current_order_option = DESCENDING_ORDER;
+    if (generator.format == COLUMNAR_FORMAT) {
+        columnar_header end_marker = {0};
 
-    if (working_file == NULL) {
-        system("clear");
-        printf("Error:" ITALIC_TEXT " No file was opened"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        return working_file;
+        generator.is_failed = fwrite(&end_marker, sizeof(columnar_header), 1, generator.file) != 1 ||
+                              generator.is_failed;
     }
 
-    record **data = get_records_arr(working_file, &size);
+    clock_gettime(CLOCK_MONOTONIC, &finish);
 
-    if (size == 0) {
-        system("clear");
+    long bytes_written = ftell(generator.file);
 
-        printf("Error:" ITALIC_TEXT " Empty file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+    if (fclose(generator.file) != 0 || generator.is_failed) {
+        printf("Error: can't write to %s\n", argv[2]);
+        return 1;
     }
 
-    do {
-        system("clear");
+    double seconds = (double) (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9;
 
-        show_records(NOT_INTERACTIVE, working_file_name, size, data);
+    printf("Generated %li %s records (%s, %i threads) into %s: %.1lf MB in %.2lf s\n",
+           generator.rows, distribution_names[generator.distribution],
+           generator.format == CSV_FORMAT ? "text" : export_format_names[generator.format], num_of_workers, argv[2],
+           bytes_written / 1e6, seconds);
 
-        if (!is_chosen_sort) {
-            show_sort_options(current_sort_option);
-            current_sort_option = navigate_list(current_sort_option, NUMBER_OF_SORTS,
-                                                &is_exit, &is_chosen_sort);
-        }
+    return 0;
+}
 
-        if (is_exit) {
-            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-                   "close the program or any other button to return to the menu");
-            return working_file;
-        }
+void init_metrics() {
+    const char *enabled = getenv("KP9_METRICS");
 
-        if (is_chosen_sort) {
-            system("clear");
+    metrics.is_enabled = enabled == NULL || strcmp(enabled, "0") != 0;
+}
 
-            show_records(NOT_INTERACTIVE, working_file_name, size, data);
-            show_sort_options(current_sort_option);
-            show_order_options(current_order_option);
-            current_order_option = navigate_list(current_order_option, NUMBER_OF_ORDERS,
-                                                 &is_exit, &is_chosen_order);
-        }
+uint64_t get_time_ns() {
+    struct timespec now;
 
-        if (is_exit) {
-            printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-                   "close the program or any other button to return to the menu");
-            return working_file;
-        }
+    clock_gettime(CLOCK_MONOTONIC, &now);
 
-    } while (!is_chosen_sort || !is_chosen_order);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
 
-    sort_records(data, size, current_sort_option, current_order_option);
+uint64_t start_timer() {
+    if (!metrics.is_enabled) {
+        return 0;
+    }
 
-    system("clear");
+    return get_time_ns();
+}
 
-    printf("File was sorted by %s in %s successfully!\nYour updated file:\n",
-           sort_option_names[current_sort_option],
-           order_option_names[current_order_option]);
+void stop_timer(enum metric_timer timer, uint64_t start) {
+    if (start == 0) {
+        return;
+    }
 
-    char temp_filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(temp_filepath, sizeof(temp_filepath), "%s/%s", working_folder, "temp.txt");
+    uint64_t elapsed = get_time_ns() - start;
+    metric_timer_value *value = &metrics.timers[timer];
+    uint64_t max_ns = __atomic_load_n(&value->max_ns, __ATOMIC_RELAXED);
 
-    FILE *temp_file = fopen(temp_filepath, "w");
+    __atomic_add_fetch(&value->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&value->total_ns, elapsed, __ATOMIC_RELAXED);
 
-    if (temp_file == NULL) {
-        printf("Error:" ITALIC_TEXT " Can't create temporary file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+    while (elapsed > max_ns &&
+           !__atomic_compare_exchange_n(&value->max_ns, &max_ns, elapsed, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
     }
+}
 
-    for (int i = 0; i < size; i++) {
-        write_record(temp_file, data[i]);
+void add_counter(enum metric_counter counter, uint64_t value) {
+    if (metrics.is_enabled) {
+        __atomic_add_fetch(&metrics.counters[counter], value, __ATOMIC_RELAXED);
     }
+}
 
-    fclose(working_file);
-    fclose(temp_file);
-
-    char filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, working_file_name);
+void show_stats() {
+    system("clear");
 
-    if (rename(temp_filepath, filepath) != 0) {
-        printf("Error:" ITALIC_TEXT " Can't rename temporary file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
+    if (!metrics.is_enabled) {
+        printf("Metrics are disabled (KP9_METRICS=0)");
         printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
                "close the program or any other button to return to the menu");
-        return working_file;
+        return;
     }
 
-    working_file = fopen(filepath, "a+");
+    printf("%-12s%12s%16s%16s%16s\n", "OPERATION", "COUNT", "TOTAL, ms", "AVERAGE, us", "MAX, us");
 
-    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+    for (int timer = 0; timer < NUMBER_OF_TIMERS; timer++) {
+        metric_timer_value value;
 
-    free_records_arr(data, size);
+        value.count = __atomic_load_n(&metrics.timers[timer].count, __ATOMIC_RELAXED);
+        value.total_ns = __atomic_load_n(&metrics.timers[timer].total_ns, __ATOMIC_RELAXED);
+        value.max_ns = __atomic_load_n(&metrics.timers[timer].max_ns, __ATOMIC_RELAXED);
+
+        printf("%-12s%12llu%16.3f%16.3f%16.3f\n", metric_timer_names[timer],
+               (unsigned long long) value.count, (double) value.total_ns / 1e6,
+               value.count ? (double) value.total_ns / (double) value.count / 1e3 : 0.0,
+               (double) value.max_ns / 1e3);
+    }
+
+    printf("\n%-16s%20s\n", "COUNTER", "VALUE");
+
+    for (int counter = 0; counter < NUMBER_OF_COUNTERS; counter++) {
+        printf("%-16s%20llu\n", metric_counter_names[counter],
+               (unsigned long long) __atomic_load_n(&metrics.counters[counter], __ATOMIC_RELAXED));
+    }
 
     printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
            "close the program or any other button to return to the menu");
-
-    return working_file;
 }
 
-FILE *insert_record(FILE *working_file, char *working_file_name) {
-    int size = 0;
-    enum sort_option sorting_option;
-    enum order_option ordering_option;
+void dump_metrics() {
+    const char *filepath = getenv("KP9_METRICS_FILE");
 
-    if (working_file == NULL) {
-        system("clear");
-        printf("Error:" ITALIC_TEXT " No file was opened"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        return working_file;
+    if (!metrics.is_enabled || filepath == NULL || *filepath == '\0') {
+        return;
     }
 
-    record **data = get_records_arr(working_file, &size);
+    FILE *file = fopen(filepath, "w");
 
-    if (size == 0) {
-        system("clear");
+    if (file == NULL) {
+        return;
+    }
 
-        printf("Error:" ITALIC_TEXT " Empty file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+    fprintf(file, "{\"pid\": %ld, \"timers\": {", (long) getpid());
+
+    for (int timer = 0; timer < NUMBER_OF_TIMERS; timer++) {
+        metric_timer_value *value = &metrics.timers[timer];
+
+        fprintf(file, "%s\"%s\": {\"count\": %llu, \"total_ns\": %llu, \"max_ns\": %llu}",
+                timer ? ", " : "", metric_timer_names[timer],
+                (unsigned long long) __atomic_load_n(&value->count, __ATOMIC_RELAXED),
+                (unsigned long long) __atomic_load_n(&value->total_ns, __ATOMIC_RELAXED),
+                (unsigned long long) __atomic_load_n(&value->max_ns, __ATOMIC_RELAXED));
     }
 
-    if (!check_sort_order(data, size, &sorting_option, &ordering_option)) {
-        system("clear");
-        printf("Error:" ITALIC_TEXT " Records are not sorted"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        return working_file;
+    fprintf(file, "}, \"counters\": {");
+
+    for (int counter = 0; counter < NUMBER_OF_COUNTERS; counter++) {
+        fprintf(file, "%s\"%s\": %llu", counter ? ", " : "", metric_counter_names[counter],
+                (unsigned long long) __atomic_load_n(&metrics.counters[counter], __ATOMIC_RELAXED));
     }
 
+    fprintf(file, "}}\n");
+    fclose(file);
+}
 
-    system("clear");
-    show_records(NOT_INTERACTIVE, working_file_name, size, data);
-    printf("\nRecords are sorted " GREEN_BG BLACK_TEXT "by %s in %s\n" BLACK_BG GREEN_TEXT,
-           sort_option_names[sorting_option],
-           order_option_names[ordering_option]);
+void init_tracing(const char *path) {
+    if (path == NULL) {
+        path = getenv("KP9_TRACE_FILE");
+    }
 
-    char temp_filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(temp_filepath, sizeof(temp_filepath), "%s/%s", working_folder, "temp.txt");
+    if (path == NULL || *path == '\0' || strlen(path) >= PATH_SIZE) {
+        return;
+    }
 
-    FILE *temp_file = fopen(temp_filepath, "w");
+    strcpy(tracing.path, path);
+    tracing.start_ns = get_time_ns();
+    tracing.is_enabled = true;
+}
 
-    if (temp_file == NULL) {
-        printf("Error:" ITALIC_TEXT " Can't create temporary file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+trace_buffer *get_trace_buffer() {
+    if (thread_trace != NULL) {
+        return thread_trace;
     }
 
-    record input_data;
+    trace_buffer *buffer = (trace_buffer *) malloc(sizeof(trace_buffer));
 
-    do {
-        printf("\nEnter name of region (max %i characters): ", REGION_NAME_MAX - 1);
-    } while (!string_input(input_data.region_name, REGION_NAME_MAX));
+    if (buffer == NULL) {
+        return NULL;
+    }
 
-    do {
-        printf("\nEnter size of region area [%.0lf; %.0lf]: ", area_min, area_max);
-    } while (!input_double(&input_data.region_area) ||
-             !is_correct_area(&input_data.region_area, area_min, area_max));
+    buffer->tid = (long) syscall(SYS_gettid);
+    buffer->size = 0;
 
-    do {
-        printf("\nEnter population of region [%i; %i]: ", population_min, population_max);
-    } while (!input_int(&input_data.region_population) ||
-             !is_correct_population(&input_data.region_population,
-                                    population_min, population_max));
+    pthread_mutex_lock(&tracing.mutex);
+    buffer->next = tracing.buffers;
+    tracing.buffers = buffer;
+    pthread_mutex_unlock(&tracing.mutex);
 
-    int insert_position = find_insert_position((const record **) data,
-                                               size, &input_data,
-                                               sorting_option, ordering_option);
+    thread_trace = buffer;
 
-    int i;
-    for (i = 0; i < size; i++) {
-        if (i == insert_position) {
-            write_record(temp_file, &input_data);
-        }
-        write_record(temp_file, data[i]);
+    return buffer;
+}
+
+uint64_t begin_span() {
+    if (!tracing.is_enabled) {
+        return 0;
     }
 
-    if (i == insert_position) {
-        write_record(temp_file, &input_data);
+    return get_time_ns();
+}
+
+void end_span(const char *name, uint64_t start) {
+    if (start == 0) {
+        return;
     }
 
-    fclose(working_file);
-    fclose(temp_file);
+    uint64_t end = get_time_ns();
+    trace_buffer *buffer = get_trace_buffer();
 
-    size++;
+    if (buffer == NULL) {
+        return;
+    }
 
-    char filepath[FILENAME_SIZE + strlen(working_folder) + 2];
-    snprintf(filepath, sizeof(filepath), "%s/%s", working_folder, working_file_name);
+    trace_event *event = &buffer->events[buffer->size % TRACE_BUFFER_EVENTS];
+    event->name = name;
+    event->start_ns = start;
+    event->duration_ns = end - start;
+    buffer->size++;
+}
 
-    if (rename(temp_filepath, filepath) != 0) {
-        printf("Error:" ITALIC_TEXT " Can't rename temporary file"
-               RESET_TEXT GREEN_TEXT BLACK_BG BOLD_TEXT);
-        printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-               "close the program or any other button to return to the menu");
-        return working_file;
+void write_trace() {
+    if (!tracing.is_enabled) {
+        return;
     }
 
-    working_file = fopen(filepath, "a+");
+    FILE *file = fopen(tracing.path, "w");
 
-    system("clear");
-    printf("\n Record was inserted successfully!\n");
+    if (file == NULL) {
+        return;
+    }
 
-    data = get_records_arr(working_file, &size);
-    show_records(NOT_INTERACTIVE, working_file_name, size, data);
+    long pid = (long) getpid();
+    bool is_first = true;
 
-    printf("\n\nPress "GREEN_BG BLACK_TEXT"ESC"BLACK_BG GREEN_TEXT" to "
-           "close the program or any other button to return to the menu");
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
 
-    free_records_arr(data, size);
+    pthread_mutex_lock(&tracing.mutex);
 
-    return working_file;
+    for (trace_buffer *buffer = tracing.buffers; buffer != NULL; buffer = buffer->next) {
+        uint64_t first = buffer->size > TRACE_BUFFER_EVENTS ? buffer->size - TRACE_BUFFER_EVENTS : 0;
+
+        fprintf(file, "%s\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": %ld, \"tid\": %ld, "
+                      "\"args\": {\"name\": \"%s\"}}",
+                is_first ? "" : ",", pid, buffer->tid, buffer->tid == pid ? "main" : "worker");
+        is_first = false;
+
+        for (uint64_t i = first; i < buffer->size; i++) {
+            trace_event *event = &buffer->events[i % TRACE_BUFFER_EVENTS];
+
+            fprintf(file, ",\n{\"ph\": \"X\", \"cat\": \"kp9\", \"name\": \"%s\", \"pid\": %ld, \"tid\": %ld, "
+                          "\"ts\": %.3f, \"dur\": %.3f}",
+                    event->name, pid, buffer->tid,
+                    (double) (event->start_ns - tracing.start_ns) / 1e3, (double) event->duration_ns / 1e3);
+        }
+    }
+
+    pthread_mutex_unlock(&tracing.mutex);
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
 }
 
-int main() {
+#ifndef KP9_NO_MAIN
+
+int main(int argc, char *argv[]) {
     bool is_chosen = false, is_exit = false;
     char *working_file_name = NULL;
     enum action current_option = CREATE_FILE;
     FILE *working_file = NULL;
+    const char *trace_path = NULL;
+
+    if (argc > 2 && strcmp(argv[1], "--trace") == 0) {
+        trace_path = argv[2];
+        argc -= 2;
+        argv += 2;
+    }
+
+    init_metrics();
+    init_tracing(trace_path);
+    atexit(dump_metrics);
+    atexit(write_trace);
+
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        return run_server();
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--client") == 0) {
+        return run_client();
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--generate") == 0) {
+        return run_generator(argc, argv);
+    }
 
     printf(BLACK_BG);
 
@@ -1448,11 +9889,14 @@ int main() {
             current_option = (enum action) get_user_choice(current_option, &is_exit, &is_chosen);
 
             if (is_exit) {
+                close_working_file(working_file, working_file_name);
                 return 0;
             }
 
         } while (!is_chosen);
 
+        uint64_t action_span = begin_span();
+
         switch (current_option) {
             case CREATE_FILE:
                 create_file();
@@ -1461,13 +9905,13 @@ int main() {
                 working_file = open_file(working_file, &working_file_name);
                 break;
             case DELETE_FILE:
-                working_file = delete_file(working_file);
+                working_file = delete_file(working_file, working_file_name);
                 break;
             case CREATE_RECORD:
                 create_record(working_file, working_file_name);
                 break;
             case READ_RECORD:
-                read_record(working_file, working_file_name);
+                working_file = read_record(working_file, working_file_name);
                 break;
             case DELETE_RECORD:
                 working_file = delete_record(working_file, working_file_name);
@@ -1481,18 +9925,50 @@ int main() {
             case INSERT_RECORD:
                 working_file = insert_record(working_file, working_file_name);
                 break;
+            case VIEW_RECORDS:
+                working_file = view_records(working_file, working_file_name);
+                break;
+            case BULK_RECORDS:
+                working_file = bulk_change_records(working_file, working_file_name);
+                break;
+            case IMPORT_RECORDS:
+                working_file = import_records(working_file, working_file_name);
+                break;
+            case EXPORT_RECORDS:
+                working_file = export_records(working_file, working_file_name);
+                break;
+            case MERGE_FILES:
+                working_file = merge_files(working_file, working_file_name);
+                break;
+            case QUERY_FILES:
+                working_file = query_files(working_file, working_file_name);
+                break;
+            case TOP_RECORDS:
+                working_file = top_records(working_file, working_file_name);
+                break;
+            case GROUP_RECORDS:
+                working_file = group_by_name(working_file, working_file_name);
+                break;
+            case SHOW_STATS:
+                show_stats();
+                break;
             default:
                 printf("default case\n");
                 break;
         }
 
+        working_file = flush_working_log(working_file, working_file_name, WAL_CHECKPOINT_SIZE);
+        commit_working_log();
+
+        end_span(action_names[current_option], action_span);
+
         is_chosen = false;
 
     } while (key_pressed() != EXIT_BUTTON);
 
-    if (working_file != NULL) {
-        fclose(working_file);
-    }
+    close_working_file(working_file, working_file_name);
 
     return 0;
 }
+
+#endif